@@ -0,0 +1,221 @@
+/*
+ * hash_table_bench.c
+ *
+ * Chained hash_table vs. use_flat_hash_table, in ns per key, for insert,
+ * lookup hits, lookup misses and traverse. "interned" keys hash and compare
+ * by pointer, like crapport's Index_Table; "string" keys hash and compare by
+ * content, like Name_Index.
+ *
+ * Build with ./build.sh bench, then run bench/hash_table_bench [reps].
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../hash_table.h"
+
+typedef const char *Str;
+
+static uint64_t str_hash(Str s) {
+    uint64_t hash = 5381;
+    int      c;
+
+    while ((c = *s++)) { hash = ((hash << 5) + hash) + c; }
+
+    return hash;
+}
+
+static int      str_equ(Str a, Str b) { return strcmp(a, b) == 0; }
+static uint64_t ptr_hash(Str s)       { return ((uint64_t)(uintptr_t)s * 0x9E3779B97F4A7C15ULL) >> 17; }
+static int      ptr_equ(Str a, Str b) { return a == b; }
+
+use_hash_table(Str, int);
+typedef hash_table(Str, int) Chained_Table;
+
+use_flat_hash_table(Flat_Ptr_Table, Str, int, ptr_hash, ptr_equ);
+use_flat_hash_table(Flat_Str_Table, Str, int, str_hash, str_equ);
+
+typedef struct {
+    double insert;
+    double hit;
+    double miss;
+    double traverse;
+} Timings;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Keeps the compiler from dropping lookups whose results aren't otherwise used. */
+static volatile long sink;
+
+static void bench_chained(Str *keys, Str *misses, int n, int by_ptr, Timings *out) {
+    Chained_Table  t;
+    double         start;
+    long           sum;
+    int            i;
+    int           *val;
+    Str            key;
+
+    t = by_ptr ? hash_table_make_e(Str, int, ptr_hash, ptr_equ)
+               : hash_table_make_e(Str, int, str_hash, str_equ);
+
+    start = now_ns();
+    for (i = 0; i < n; i += 1) { hash_table_insert(t, keys[i], i); }
+    out->insert = (now_ns() - start) / n;
+
+    sum   = 0;
+    start = now_ns();
+    for (i = 0; i < n; i += 1) {
+        if ((val = hash_table_get_val(t, keys[i])) != NULL) { sum += *val; }
+    }
+    out->hit = (now_ns() - start) / n;
+
+    start = now_ns();
+    for (i = 0; i < n; i += 1) {
+        if (hash_table_get_val(t, misses[i]) != NULL) { sum += 1; }
+    }
+    out->miss = (now_ns() - start) / n;
+
+    start = now_ns();
+    hash_table_traverse(t, key, val) { sum += *val + (long)(uintptr_t)key; }
+    out->traverse = (now_ns() - start) / n;
+
+    sink = sum;
+
+    hash_table_free(t);
+}
+
+#define BENCH_FLAT(NAME)                                                            \
+static void bench_##NAME(Str *keys, Str *misses, int n, Timings *out) {            \
+    NAME    t;                                                                      \
+    double  start;                                                                  \
+    long    sum;                                                                    \
+    int     i;                                                                      \
+    int    *val;                                                                    \
+    Str     key;                                                                    \
+                                                                                    \
+    t = flat_hash_table_make(NAME);                                                 \
+                                                                                    \
+    start = now_ns();                                                               \
+    for (i = 0; i < n; i += 1) { flat_hash_table_insert(NAME, t, keys[i], i); }     \
+    out->insert = (now_ns() - start) / n;                                           \
+                                                                                    \
+    sum   = 0;                                                                      \
+    start = now_ns();                                                               \
+    for (i = 0; i < n; i += 1) {                                                    \
+        if ((val = flat_hash_table_get_val(NAME, t, keys[i])) != NULL) {            \
+            sum += *val;                                                            \
+        }                                                                           \
+    }                                                                               \
+    out->hit = (now_ns() - start) / n;                                              \
+                                                                                    \
+    start = now_ns();                                                               \
+    for (i = 0; i < n; i += 1) {                                                    \
+        if (flat_hash_table_get_val(NAME, t, misses[i]) != NULL) { sum += 1; }      \
+    }                                                                               \
+    out->miss = (now_ns() - start) / n;                                             \
+                                                                                    \
+    start = now_ns();                                                               \
+    flat_hash_table_traverse(t, key, val) { sum += *val + (long)(uintptr_t)key; }   \
+    out->traverse = (now_ns() - start) / n;                                         \
+                                                                                    \
+    sink = sum;                                                                     \
+                                                                                    \
+    flat_hash_table_free(NAME, t);                                                  \
+}
+
+BENCH_FLAT(Flat_Ptr_Table)
+BENCH_FLAT(Flat_Str_Table)
+
+/* Names shaped like crapport's run directories, so string hashing costs what it does there. */
+static Str *make_keys(int n, const char *prefix) {
+    Str  *keys;
+    char  buff[64];
+    int   i;
+
+    keys = malloc(n * sizeof(*keys));
+    for (i = 0; i < n; i += 1) {
+        snprintf(buff, sizeof(buff), "%s/bench_%02d/run_%08d", prefix, i % 97, i);
+        keys[i] = strdup(buff);
+    }
+
+    return keys;
+}
+
+static void free_keys(Str *keys, int n) {
+    int i;
+
+    for (i = 0; i < n; i += 1) { free((char*)keys[i]); }
+    free(keys);
+}
+
+static void keep_min(Timings *best, Timings *t) {
+    if (t->insert   < best->insert)   { best->insert   = t->insert;   }
+    if (t->hit      < best->hit)      { best->hit      = t->hit;      }
+    if (t->miss     < best->miss)     { best->miss     = t->miss;     }
+    if (t->traverse < best->traverse) { best->traverse = t->traverse; }
+}
+
+int main(int argc, char **argv) {
+    static const int sizes[] = { 32, 1000, 100000, 1000000 };
+    int              reps;
+    int              by_ptr;
+    unsigned         s;
+    int              n;
+    int              r;
+    Str             *keys;
+    Str             *misses;
+    Timings          t;
+    Timings          chained;
+    Timings          flat;
+
+    reps = argc > 1 ? atoi(argv[1]) : 3;
+    if (reps < 1) { reps = 1; }
+
+    printf("ns per key, best of %d       insert          hit             miss            traverse\n", reps);
+    printf("                             chained   flat  chained   flat  chained   flat  chained   flat\n");
+
+    for (by_ptr = 1; by_ptr >= 0; by_ptr -= 1) {
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s += 1) {
+            n      = sizes[s];
+            keys   = make_keys(n, "runs");
+            misses = make_keys(n, "gone");
+
+            chained.insert = chained.hit = chained.miss = chained.traverse = 1e30;
+            flat = chained;
+
+            for (r = 0; r < reps; r += 1) {
+                bench_chained(keys, misses, n, by_ptr, &t);
+                keep_min(&chained, &t);
+
+                if (by_ptr) {
+                    bench_Flat_Ptr_Table(keys, misses, n, &t);
+                } else {
+                    bench_Flat_Str_Table(keys, misses, n, &t);
+                }
+                keep_min(&flat, &t);
+            }
+
+            printf("%-8s %8d keys  %7.1f %6.1f  %7.1f %6.1f  %7.1f %6.1f  %7.1f %6.1f\n",
+                   by_ptr ? "interned" : "string", n,
+                   chained.insert,   flat.insert,
+                   chained.hit,      flat.hit,
+                   chained.miss,     flat.miss,
+                   chained.traverse, flat.traverse);
+
+            free_keys(keys,   n);
+            free_keys(misses, n);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * props_bench.c
+ *
+ * crapport's in-place props tokenizer (parse_props()) against the
+ * fgets()-based reader it replaced, in us per file, for small props files
+ * (read() in one go) and big ones (mapped). Both sides intern keys and
+ * classify values with the same parse_value(), so the difference is the
+ * reading and the line splitting. Before anything is timed, every file has
+ * to come out with the same props from both.
+ *
+ * It includes crapport.c to get at the real parser. Nothing here calls into
+ * yed, and ./build.sh bench links with --gc-sections so that the plugin code
+ * that does is dropped. Run bench/props_bench [n_small_files]. There are a
+ * fiftieth as many big ones.
+ */
+
+#include "../crapport.c"
+
+#include <time.h>
+
+#define FGETS_LINE_MAX (1024)
+
+/* The reader as it was before the in-place one. Lines longer than the buffer get split. */
+static void ref_parse_props(Experiment *exp, Str path) {
+    char  buff[FGETS_LINE_MAX];
+    FILE *f;
+    int   len;
+    Prop  prop;
+
+    if ((f = fopen(path, "r")) == NULL) {
+        errno = 0;
+        return;
+    }
+
+    while (fgets(buff, sizeof(buff), f)) {
+        len = strlen(buff);
+        if (len > 0 && buff[len - 1] == '\n') { len -= 1; }
+        prop.key = intern_n(buff, len);
+
+        if (!fgets(buff, sizeof(buff), f)) { break; }
+
+        len = strlen(buff);
+        if (len > 0 && buff[len - 1] == '\n') { len -= 1; }
+        prop.val = parse_value(buff, len);
+
+        exp_push(exp, &prop);
+    }
+
+    fclose(f);
+}
+
+static char root[256];
+
+static double now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* n_pairs of the kinds of values a props file has. Lines stay under FGETS_LINE_MAX. */
+static int make_files(const char *kind, int n, int n_pairs) {
+    char  path[512];
+    FILE *f;
+    int   i;
+    int   j;
+
+    for (i = 0; i < n; i += 1) {
+        snprintf(path, sizeof(path), "%s/%s_%06d", root, kind, i);
+        if ((f = fopen(path, "w")) == NULL) {
+            perror(path);
+            return 0;
+        }
+
+        for (j = 0; j < n_pairs; j += 1) {
+            switch (j % 5) {
+                case 0:  fprintf(f, "metric_%d\n%.6f\n", j, (i * 31 + j * 7) % 100000 / 7.0);      break;
+                case 1:  fprintf(f, "count_%d\n%d\n", j, (i + j) % 200000);                        break;
+                case 2:  fprintf(f, "flag_%d\n%s\n", j, (i + j) % 3 ? "yes" : "no");               break;
+                case 3:  fprintf(f, "date_%d\n2024-%02d-%02dT10:00:00\n", j, 1 + i % 12, 1 + j % 28); break;
+                default: fprintf(f, "cmd_%d\nnumactl -C 0-%d ./xsbench -s large -t %d -l %d\n",
+                                 j, (i + j) % 64, j % 128, 100000 + i);                            break;
+            }
+        }
+        fclose(f);
+    }
+
+    return 1;
+}
+
+static void remove_files(const char *kind, int n) {
+    char path[512];
+    int  i;
+
+    for (i = 0; i < n; i += 1) {
+        snprintf(path, sizeof(path), "%s/%s_%06d", root, kind, i);
+        unlink(path);
+    }
+}
+
+static int same_props(Experiment *a, Experiment *b) {
+    Prop *pa;
+    Prop *pb;
+    int   i;
+
+    if (a->n_props != b->n_props) { return 0; }
+
+    pa = exp_props(a);
+    pb = exp_props(b);
+    for (i = 0; i < a->n_props; i += 1) {
+        if (pa[i].key != pb[i].key || pa[i].val.type != pb[i].val.type) { return 0; }
+
+        switch (pa[i].val.type) {
+            case STRING:  if (pa[i].val.string  != pb[i].val.string)  { return 0; } break;
+            case NUMBER:  if (pa[i].val.number  != pb[i].val.number)  { return 0; } break;
+            case BOOLEAN: if (pa[i].val.boolean != pb[i].val.boolean) { return 0; } break;
+        }
+    }
+
+    return 1;
+}
+
+static int check(const char *kind, int n) {
+    char       path[512];
+    Experiment a;
+    Experiment b;
+    u64        mtime;
+    u64        size;
+    int        i;
+    int        n_bad;
+    long       n_props;
+
+    n_bad   = 0;
+    n_props = 0;
+    for (i = 0; i < n; i += 1) {
+        snprintf(path, sizeof(path), "%s/%s_%06d", root, kind, i);
+
+        init_exp(&a);
+        init_exp(&b);
+        ref_parse_props(&a, path);
+        if (props_stat(path, &mtime, &size)) { parse_props(&b, path, size, NULL); }
+
+        if (!same_props(&a, &b)) {
+            if (n_bad < 10) { printf("  mismatch in %s\n", path); }
+            n_bad += 1;
+        }
+        n_props += b.n_props;
+
+        free_exp(&a);
+        free_exp(&b);
+    }
+
+    printf("check %-5s %6d files, %8ld props, %d mismatches\n", kind, n, n_props, n_bad);
+
+    return n_bad == 0;
+}
+
+static void bench(const char *kind, int n) {
+    char       path[512];
+    Experiment exp;
+    u64        mtime;
+    u64        size;
+    double     start;
+    double     ref;
+    double     cur;
+    double     best_ref;
+    double     best_cur;
+    int        r;
+    int        i;
+
+    best_ref = best_cur = 1e30;
+
+    for (r = 0; r < 5; r += 1) {
+        start = now_us();
+        for (i = 0; i < n; i += 1) {
+            snprintf(path, sizeof(path), "%s/%s_%06d", root, kind, i);
+            init_exp(&exp);
+            ref_parse_props(&exp, path);
+            free_exp(&exp);
+        }
+        ref = (now_us() - start) / n;
+
+        /* The stat is part of what parse_exp() does anyway, so it's counted. */
+        start = now_us();
+        for (i = 0; i < n; i += 1) {
+            snprintf(path, sizeof(path), "%s/%s_%06d", root, kind, i);
+            init_exp(&exp);
+            if (props_stat(path, &mtime, &size)) { parse_props(&exp, path, size, NULL); }
+            free_exp(&exp);
+        }
+        cur = (now_us() - start) / n;
+
+        if (ref < best_ref) { best_ref = ref; }
+        if (cur < best_cur) { best_cur = cur; }
+    }
+
+    printf("bench %-5s fgets() %7.2f us/file, parse_props() %7.2f us/file (%.1fx)\n",
+           kind, best_ref, best_cur, best_ref / best_cur);
+}
+
+int main(int argc, char **argv) {
+    int n_small;
+    int n_big;
+    int ok;
+
+    n_small = argc > 1 ? atoi(argv[1]) : 20000;
+    if (n_small < 1) { n_small = 1; }
+    n_big = n_small / 50 + 1;
+
+    arena_init();
+    intern_init();
+
+    snprintf(root, sizeof(root), "/tmp/crapport-props-bench-XXXXXX");
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    /* About 1.3KB, like most runs, and about 90KB, past PROPS_READ_MAX. */
+    ok = make_files("small", n_small, 40) && make_files("big", n_big, 2500);
+
+    if (ok) {
+        ok  = check("small", n_small);
+        ok &= check("big",   n_big);
+    }
+
+    if (ok) {
+        bench("small", n_small);
+        bench("big",   n_big);
+    }
+
+    remove_files("small", n_small);
+    remove_files("big",   n_big);
+    rmdir(root);
+
+    return !ok;
+}
@@ -0,0 +1,140 @@
+/*
+ * threadpool_bench.c
+ *
+ * The classic pool vs. TP_STEAL from 1 to 64 workers, on three shapes of
+ * work:
+ *
+ *   flat   Tasks added one at a time from outside the pool, like the UI
+ *          thread queueing a load. Both modes go through the shared queue.
+ *   tree   A binary tree of tasks, each adding its two children from inside
+ *          the pool, like load enumeration. This is what the deques are for.
+ *   groups Fork-join: tasks that each fill a tp_group and wait on it from
+ *          inside the pool, like a Jule run waiting on a projection load.
+ *          TP_STEAL only; the classic pool can't wait from a worker.
+ *
+ * Each task does a little arithmetic so that the numbers aren't all queue
+ * overhead. Build with ./build.sh bench, then run
+ * bench/threadpool_bench [max_workers].
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define THREADPOOL_IMPLEMENTATION
+#include "../threadpool.h"
+
+#define FLAT_TASKS   (200000)
+#define TREE_DEPTH   (17)
+#define GROUPS       (256)
+#define GROUP_TASKS  (256)
+#define TASK_WORK    (200)
+
+static tp_t *pool;
+static long  n_done;
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void leaf(void *arg) {
+    volatile unsigned x;
+    int               i;
+
+    (void)arg;
+
+    x = 0;
+    for (i = 0; i < TASK_WORK; i += 1) { x += i * 2654435761u; }
+
+    __atomic_add_fetch(&n_done, 1, __ATOMIC_RELAXED);
+}
+
+static void tree(void *arg) {
+    intptr_t depth;
+
+    depth = (intptr_t)arg;
+
+    if (depth == 0) {
+        leaf(NULL);
+        return;
+    }
+
+    tp_add_task(pool, tree, (void*)(depth - 1));
+    tp_add_task(pool, tree, (void*)(depth - 1));
+}
+
+static void fork_join(void *arg) {
+    tp_group_t *group;
+    int         i;
+
+    (void)arg;
+
+    group = tp_group_make(pool);
+    for (i = 0; i < GROUP_TASKS; i += 1) {
+        tp_group_add_task(group, leaf, NULL);
+    }
+    tp_group_free(group);
+}
+
+static double run(void (*fn)(void*), void *arg, int n, long want, const char *what) {
+    double start;
+    double ms;
+    int    i;
+
+    n_done = 0;
+    start  = now_ms();
+
+    for (i = 0; i < n; i += 1) { tp_add_task(pool, fn, arg); }
+    tp_wait(pool);
+
+    ms = now_ms() - start;
+
+    if (n_done != want) {
+        fprintf(stderr, "%s: ran %ld tasks, expected %ld\n", what, n_done, want);
+        exit(1);
+    }
+
+    return ms;
+}
+
+int main(int argc, char **argv) {
+    int    max_workers;
+    int    n;
+    int    steal;
+    double flat;
+    double spawn;
+    double groups;
+
+    max_workers = argc > 1 ? atoi(argv[1]) : 64;
+
+    printf("workers  mode        flat %dk   tree 2^%d   groups %dx%d   (ms)\n",
+           FLAT_TASKS / 1000, TREE_DEPTH, GROUPS, GROUP_TASKS);
+
+    for (n = 1; n <= max_workers; n *= 2) {
+        for (steal = 0; steal <= 1; steal += 1) {
+            pool = tp_make_ex(n, steal ? TP_STEAL : 0);
+
+            flat  = run(leaf, NULL, FLAT_TASKS, FLAT_TASKS, "flat");
+            spawn = run(tree, (void*)(intptr_t)TREE_DEPTH, 1, 1L << TREE_DEPTH, "tree");
+
+            if (steal) {
+                groups = run(fork_join, NULL, GROUPS, (long)GROUPS * GROUP_TASKS, "groups");
+                printf("%7d  %-8s %10.1f %11.1f %13.1f\n", n, "steal", flat, spawn, groups);
+            } else {
+                printf("%7d  %-8s %10.1f %11.1f %13s\n", n, "classic", flat, spawn, "-");
+            }
+
+            tp_stop(pool, TP_GRACEFUL);
+            tp_free(pool);
+        }
+    }
+
+    return 0;
+}
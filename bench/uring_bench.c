@@ -0,0 +1,248 @@
+/*
+ * uring_bench.c
+ *
+ * The two ways a parse chunk's props files can be read: one statx, openat,
+ * read and close per run (parse_exp()), or the same calls batched through
+ * each worker's io_uring (load_chunk_uring()). Runs a synthetic tree of runs
+ * through both, chunk by chunk like a load does, with a warm page cache and
+ * with each props file dropped from it first (posix_fadvise(), so no root is
+ * needed; the directories themselves stay cached). Both paths have to find
+ * the same runs and props before anything is timed.
+ *
+ * It includes crapport.c to get at the real load code. Nothing here calls
+ * into yed, and ./build.sh bench links with --gc-sections so that the plugin
+ * code that does is dropped. Run bench/uring_bench [n_runs] [n_threads].
+ */
+
+#include "../crapport.c"
+
+#include <time.h>
+
+static int   n_runs;
+static int   n_threads;
+static int   n_chunks;
+static char *names;  /* NUL-separated, in chunk order */
+static int  *chunk_offs;
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Props files shaped like the ones in a campaign: about 40 pairs, a bit over 1KB. */
+static int make_tree(void) {
+    char  path[sizeof(load_root) + 1024];
+    FILE *f;
+    int   i;
+    int   j;
+    int   off;
+
+    snprintf(load_root, sizeof(load_root), "/tmp/crapport-uring-bench-XXXXXX");
+    if (mkdtemp(load_root) == NULL) {
+        perror("mkdtemp");
+        return 0;
+    }
+    load_root_len = strlen(load_root);
+
+    names      = malloc(n_runs * 16);
+    n_chunks   = (n_runs + LOAD_CHUNK_SIZE - 1) / LOAD_CHUNK_SIZE;
+    chunk_offs = malloc((n_chunks + 1) * sizeof(*chunk_offs));
+
+    off = 0;
+    for (i = 0; i < n_runs; i += 1) {
+        if (i % LOAD_CHUNK_SIZE == 0) { chunk_offs[i / LOAD_CHUNK_SIZE] = off; }
+
+        off += sprintf(names + off, "run_%08d", i) + 1;
+
+        snprintf(path, sizeof(path), "%s/run_%08d", load_root, i);
+        mkdir(path, 0755);
+        snprintf(path, sizeof(path), "%s/run_%08d/props", load_root, i);
+        if ((f = fopen(path, "w")) == NULL) {
+            perror(path);
+            return 0;
+        }
+
+        fprintf(f, "benchmark\nxsbench\nsize\nlarge\nthreads\n%d\nnodes\n%d\n", 1 << (i % 7), 1 + i % 16);
+        fprintf(f, "cmd\nnumactl -C 0-%d ./xsbench -s large -t %d -l %d\n", i % 64, i % 128, 100000 + i);
+        fprintf(f, "date\n2024-%02d-%02dT10:00:00\nok\n%s\n", 1 + i % 12, 1 + i % 28, i % 5 ? "yes" : "no");
+        for (j = 0; j < 32; j += 1) {
+            fprintf(f, "metric_%02d\n%.6f\n", j, (i * 31 + j * 7) % 100000 / 7.0);
+        }
+        fclose(f);
+    }
+    chunk_offs[n_chunks] = off;
+
+    return 1;
+}
+
+static void remove_tree(void) {
+    char path[sizeof(load_root) + 1024];
+    int  i;
+
+    for (i = 0; i < n_runs; i += 1) {
+        snprintf(path, sizeof(path), "%s/run_%08d/props", load_root, i);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/run_%08d", load_root, i);
+        rmdir(path);
+    }
+    rmdir(load_root);
+}
+
+static void drop_cache(void) {
+    char path[sizeof(load_root) + 1024];
+    int  fd;
+    int  i;
+
+    for (i = 0; i < n_runs; i += 1) {
+        snprintf(path, sizeof(path), "%s/run_%08d/props", load_root, i);
+        if ((fd = open(path, O_RDONLY)) >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+typedef struct {
+    int       thread;
+    int       uring;
+    long      n_exps;
+    long      n_props;
+    pthread_t tid;
+} Worker;
+
+static Load_Chunk *make_chunk(int c) {
+    Load_Chunk *chunk;
+
+    chunk          = load_chunk_make(LOAD_PARSE, 0, 1);
+    chunk->n       = MIN(LOAD_CHUNK_SIZE, n_runs - c * LOAD_CHUNK_SIZE);
+    chunk->results = array_make_with_cap(Experiment, chunk->n);
+    array_push_n(chunk->names, names + chunk_offs[c], chunk_offs[c + 1] - chunk_offs[c]);
+
+    return chunk;
+}
+
+static void *worker(void *arg) {
+    Worker     *w;
+    Load_Chunk *chunk;
+    Load_Chunk *next;
+    Experiment *exp;
+    Experiment  e;
+    const char *name;
+    char        path[sizeof(load_root) + 1024];
+    int         c;
+    int         i;
+
+    w = arg;
+
+    for (c = w->thread; c < n_chunks; c += n_threads) {
+        chunk = make_chunk(c);
+        next  = NULL;
+
+        if (w->uring) {
+            if (!load_chunk_uring(chunk, &next)) {
+                fprintf(stderr, "load_chunk_uring() couldn't use its ring\n");
+                exit(1);
+            }
+        } else {
+            name = array_data(chunk->names);
+            for (i = 0; i < chunk->n; i += 1) {
+                snprintf(path, sizeof(path), "%s/%s", load_root, name);
+                if (parse_exp(path, &e)) { array_push(chunk->results, e); }
+                name += strlen(name) + 1;
+            }
+        }
+
+        array_traverse(chunk->results, exp) {
+            w->n_exps  += 1;
+            w->n_props += exp->n_props;
+        }
+
+        if (next != NULL) { load_chunk_free(next); }
+        load_chunk_free(chunk);
+    }
+
+    return NULL;
+}
+
+/* Returns ms, and the runs and props found in *n_exps and *n_props. */
+static double run(int uring, long *n_exps, long *n_props) {
+    Worker  workers[256];
+    double  start;
+    int     i;
+
+    *n_exps  = 0;
+    *n_props = 0;
+
+    start = now_ms();
+
+    for (i = 0; i < n_threads; i += 1) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].thread = i;
+        workers[i].uring  = uring;
+        pthread_create(&workers[i].tid, NULL, worker, &workers[i]);
+    }
+    for (i = 0; i < n_threads; i += 1) {
+        pthread_join(workers[i].tid, NULL);
+        *n_exps  += workers[i].n_exps;
+        *n_props += workers[i].n_props;
+    }
+
+    return now_ms() - start;
+}
+
+int main(int argc, char **argv) {
+    long   n_exps[2];
+    long   n_props[2];
+    double best[2][2];
+    double ms;
+    int    cold;
+    int    uring;
+    int    r;
+
+    n_runs    = argc > 1 ? atoi(argv[1]) : 20000;
+    n_threads = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_runs    < 1)   { n_runs    = 1;   }
+    if (n_threads < 1)   { n_threads = 1;   }
+    if (n_threads > 256) { n_threads = 256; }
+
+    arena_init();
+    intern_init();
+
+    if (!load_uring_probe()) {
+        fprintf(stderr, "io_uring doesn't support statx/openat/read/close here\n");
+        return 1;
+    }
+
+    if (!make_tree()) { return 1; }
+
+    for (uring = 0; uring <= 1; uring += 1) {
+        run(uring, &n_exps[uring], &n_props[uring]);
+    }
+    printf("check %d runs: read() found %ld runs, %ld props; io_uring %ld runs, %ld props\n",
+           n_runs, n_exps[0], n_props[0], n_exps[1], n_props[1]);
+
+    if (n_exps[0] != n_runs || n_exps[0] != n_exps[1] || n_props[0] != n_props[1]) {
+        remove_tree();
+        return 1;
+    }
+
+    for (cold = 0; cold <= 1; cold += 1) {
+        best[cold][0] = best[cold][1] = 1e30;
+        for (r = 0; r < 5; r += 1) {
+            for (uring = 0; uring <= 1; uring += 1) {
+                if (cold) { drop_cache(); }
+                ms = run(uring, &n_exps[uring], &n_props[uring]);
+                if (ms < best[cold][uring]) { best[cold][uring] = ms; }
+            }
+        }
+        printf("bench %-5s %d threads: read() %8.1f ms, io_uring %8.1f ms (%.2fx)\n",
+               cold ? "cold" : "warm", n_threads, best[cold][0], best[cold][1], best[cold][0] / best[cold][1]);
+    }
+
+    remove_tree();
+
+    return 0;
+}
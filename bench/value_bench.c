@@ -0,0 +1,343 @@
+/*
+ * value_bench.c
+ *
+ * crapport's parse_value() against the strtod()-based classifier it
+ * replaced, in ns per value, plus a differential check of the two. The
+ * check runs first, over fuzzed numeric-looking strings and a list of edge
+ * cases, and the benchmark only runs if every value gets the same type and
+ * the same bits from both.
+ *
+ * It includes crapport.c to get at the real parse_value(). Nothing here
+ * calls into yed, and ./build.sh bench links with --gc-sections so that the
+ * plugin code that does is dropped. Run bench/value_bench [n_values].
+ */
+
+#include "../crapport.c"
+
+#include <time.h>
+
+/*
+ * The classifier as it was before the single-pass one, verbatim but for the
+ * names. It wants NUL-terminated values, like the fgets() lines it was given,
+ * and strdup()s strings, which the caller frees.
+ */
+
+static inline int ref_is_falsey(Str str) {
+    unsigned i;
+    const char *falsey[] = { "false", "False", "FALSE", "no",  "No",  "NO",  "off", "Off", "OFF" };
+
+    for (i = 0; i < sizeof(falsey) / sizeof(falsey[0]); i += 1) {
+        if (strcmp(str, falsey[i]) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static inline int ref_is_truthy(Str str) {
+    unsigned i;
+    const char *truthy[] = { "true",  "True",  "TRUE",  "yes", "Yes", "YES", "on",  "On",  "ON"  };
+
+    for (i = 0; i < sizeof(truthy) / sizeof(truthy[0]); i += 1) {
+        if (strcmp(str, truthy[i]) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static inline int ref_parse_number(Str str, double *d) {
+    const char *eos;
+    char       *end;
+
+    eos = str + strlen(str);
+    *d  = strtod(str, &end);
+
+    return end == eos;
+}
+
+static inline Value ref_parse_value(Str str) {
+    Value val;
+
+    if (ref_is_falsey(str)) {
+        val.type    = BOOLEAN;
+        val.boolean = 0;
+        goto out;
+    }
+
+    if (ref_is_truthy(str)) {
+        val.type    = BOOLEAN;
+        val.boolean = 1;
+        goto out;
+    }
+
+    if (ref_parse_number(str, &val.number)) {
+        val.type = NUMBER;
+        goto out;
+    }
+
+    val.type   = STRING;
+    val.string = strdup(str);
+
+out:;
+    return val;
+}
+
+static void ref_free_value(Value *val) {
+    if (val->type == STRING) { free((char*)val->string); }
+}
+
+typedef struct {
+    char  *chars;
+    int   *offs;
+    int   *lens;
+    int    n;
+    int    cap;
+    int    used;
+    int    chars_cap;
+} Inputs;
+
+static void inputs_push(Inputs *in, const char *s, int len) {
+    if (in->n == in->cap) {
+        in->cap  = in->cap ? 2 * in->cap : 1024;
+        in->offs = realloc(in->offs, in->cap * sizeof(*in->offs));
+        in->lens = realloc(in->lens, in->cap * sizeof(*in->lens));
+    }
+    if (in->used + len + 1 > in->chars_cap) {
+        in->chars_cap = 2 * (in->chars_cap + len + 1);
+        in->chars     = realloc(in->chars, in->chars_cap);
+    }
+
+    /* NUL-terminated for ref_parse_value(). parse_value() is only given len. */
+    memcpy(in->chars + in->used, s, len);
+    in->chars[in->used + len] = 0;
+    in->offs[in->n]  = in->used;
+    in->lens[in->n]  = len;
+    in->used        += len + 1;
+    in->n           += 1;
+}
+
+static void inputs_free(Inputs *in) {
+    free(in->chars);
+    free(in->offs);
+    free(in->lens);
+    memset(in, 0, sizeof(*in));
+}
+
+static u64 rng_state = 0x9E3779B97F4A7C15ULL;
+
+static u64 rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+
+    return rng_state;
+}
+
+/* What a props file is mostly made of: timings, counts, flags, dates, names and command lines. */
+static void make_props_values(Inputs *in, int n) {
+    static const char *benchmarks[] = { "xsbench", "warpx", "lulesh", "amg", "minife", "hpcg" };
+    static const char *flags[]      = { "yes", "no", "true", "false", "on", "off", "True", "NO" };
+    char               buff[128];
+    int                i;
+    int                len;
+
+    for (i = 0; i < n; i += 1) {
+        switch (rng() % 8) {
+            case 0:  len = snprintf(buff, sizeof(buff), "%.3f", (rng() % 1000000) / 1000.0);                 break;
+            case 1:  len = snprintf(buff, sizeof(buff), "%d", (int)(rng() % 200000));                        break;
+            case 2:  len = snprintf(buff, sizeof(buff), "%d", (int)(rng() % 2));                             break;
+            case 3:  len = snprintf(buff, sizeof(buff), "%s", flags[rng() % 8]);                             break;
+            case 4:  len = snprintf(buff, sizeof(buff), "2024-%02d-%02dT10:00:00", (int)(rng() % 12) + 1,
+                                    (int)(rng() % 28) + 1);                                                  break;
+            case 5:  len = snprintf(buff, sizeof(buff), "%s", benchmarks[rng() % 6]);                        break;
+            case 6:  len = snprintf(buff, sizeof(buff), "%012llx", (unsigned long long)(rng() >> 16));       break;
+            default: len = snprintf(buff, sizeof(buff), "numactl -C %d ./%s -s large -t %d",
+                                    (int)(rng() % 64), benchmarks[rng() % 6], (int)(rng() % 128));           break;
+        }
+        inputs_push(in, buff, len);
+    }
+}
+
+/* Numbers only, in every format printf() has, so that both the fast and the slow path get exercised. */
+static void make_numbers(Inputs *in, int n) {
+    static const char *formats[] = { "%g", "%.17g", "%e", "%.3f", "%.0f", "%a", "%.1e" };
+    char               buff[128];
+    double             d;
+    int                i;
+    int                len;
+
+    for (i = 0; i < n; i += 1) {
+        d = (double)(rng() >> 11) / (double)(1ULL << 53);
+        d = ldexp(d, (int)(rng() % 80) - 40);
+        if (rng() & 1) { d = -d; }
+
+        len = snprintf(buff, sizeof(buff), formats[rng() % 7], d);
+        inputs_push(in, buff, len);
+    }
+}
+
+static void make_fuzz(Inputs *in, int n) {
+    static const char  alphabet[] = "0123456789000+-..eEeinfatyINFxXp \t";
+    static const char *edges[]    = {
+        "0", "-0", "+0", "0.0", "-0.0", ".5", "5.", ".", "-", "+", "e5", "1e", "1e+", "1e-5",
+        "1E22", "1e23", "1e-22", "1e-23", "9007199254740992", "9007199254740993",
+        "1234567890123456789", "12345678901234567890", "0.1234567890123456789",
+        "1e308", "1e309", "4.9e-324", "2.2250738585072014e-308", "inf", "-Infinity", "nan",
+        "NAN(123)", "0x1p3", "0X1.8P1", " 1", "\t1", "1 ", "00001", "1.5e0005", "1e99999",
+        "1e-99999", "true", "TRUE", "tRUE", "yes", "no", "off", "Off", "on", "ON", "oN", "", " ", "\t",
+        "0.0000000000000000000000000000000000000000000000000000000000000001",
+        "1234567890123456789012345678901234567890123456789012345678901234567890",
+        "   1.50000000000000000000000000000000000000000000000000000000000000",
+        "1.0000000000000000000000000000000000000000000000000000000000000000x",
+    };
+    char               buff[96];
+    unsigned           i;
+    int                j;
+    int                len;
+
+    for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i += 1) {
+        inputs_push(in, edges[i], strlen(edges[i]));
+    }
+
+    for (i = 0; i < (unsigned)n; i += 1) {
+        /* Mostly short, sometimes past the 63 bytes that parse_value() copies on the stack. */
+        len = 1 + rng() % (rng() % 8 ? 24 : 80);
+        for (j = 0; j < len; j += 1) {
+            buff[j] = alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+        inputs_push(in, buff, len);
+    }
+}
+
+static int same_value(Value *a, Value *b) {
+    if (a->type != b->type) { return 0; }
+
+    switch (a->type) {
+        case STRING:  return strcmp(a->string, b->string) == 0;
+        case BOOLEAN: return a->boolean == b->boolean;
+        case NUMBER:  return memcmp(&a->number, &b->number, sizeof(double)) == 0
+                          || (isnan(a->number) && isnan(b->number));
+    }
+
+    return 0;
+}
+
+static int check(const char *what, Inputs *in) {
+    Value  a;
+    Value  b;
+    int    i;
+    int    n_bad;
+    Str    s;
+
+    n_bad = 0;
+    for (i = 0; i < in->n; i += 1) {
+        s = in->chars + in->offs[i];
+        a = ref_parse_value(s);
+        b = parse_value(s, in->lens[i]);
+
+        if (!same_value(&a, &b)) {
+            if (n_bad < 10) {
+                printf("  mismatch on '%.*s': strtod() gives type %d (%.17g), parse_value() type %d (%.17g)\n",
+                       in->lens[i], s, a.type, a.type == NUMBER ? a.number : 0.0,
+                       b.type, b.type == NUMBER ? b.number : 0.0);
+            }
+            n_bad += 1;
+        }
+
+        ref_free_value(&a);
+    }
+
+    printf("check %-14s %9d values, %d mismatches\n", what, in->n, n_bad);
+
+    return n_bad == 0;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile double sink;
+
+static void bench(const char *what, Inputs *in) {
+    double start;
+    double ref;
+    double cur;
+    double best_ref;
+    double best_cur;
+    double sum;
+    Value  v;
+    int    r;
+    int    i;
+
+    best_ref = best_cur = 1e30;
+
+    for (r = 0; r < 5; r += 1) {
+        sum   = 0;
+        start = now_ns();
+        for (i = 0; i < in->n; i += 1) {
+            v    = ref_parse_value(in->chars + in->offs[i]);
+            sum += v.type;
+            ref_free_value(&v);
+        }
+        ref = (now_ns() - start) / in->n;
+
+        start = now_ns();
+        for (i = 0; i < in->n; i += 1) {
+            v    = parse_value(in->chars + in->offs[i], in->lens[i]);
+            sum += v.type;
+        }
+        cur = (now_ns() - start) / in->n;
+
+        sink = sum;
+
+        if (ref < best_ref) { best_ref = ref; }
+        if (cur < best_cur) { best_cur = cur; }
+    }
+
+    printf("bench %-14s strtod() %6.1f ns/value, parse_value() %6.1f ns/value (%.1fx)\n",
+           what, best_ref, best_cur, best_ref / best_cur);
+}
+
+int main(int argc, char **argv) {
+    int    n;
+    int    ok;
+    Inputs props;
+    Inputs numbers;
+    Inputs fuzz;
+
+    n = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (n < 1) { n = 1; }
+
+    arena_init();
+    intern_init();
+
+    memset(&props,   0, sizeof(props));
+    memset(&numbers, 0, sizeof(numbers));
+    memset(&fuzz,    0, sizeof(fuzz));
+
+    make_props_values(&props,   n);
+    make_numbers(&numbers,      n);
+    make_fuzz(&fuzz,            2 * n);
+
+    ok  = check("props values", &props);
+    ok &= check("numbers",      &numbers);
+    ok &= check("fuzz",         &fuzz);
+
+    if (!ok) { return 1; }
+
+    bench("props values", &props);
+    bench("numbers",      &numbers);
+
+    inputs_free(&props);
+    inputs_free(&numbers);
+    inputs_free(&fuzz);
+
+    return 0;
+}
@@ -5,4 +5,30 @@ if which pcre2-config > /dev/null; then
     PCRE2_FLAGS="$(pcre2-config --cflags-posix --libs-posix) -DYED_SYNTAX_USE_PCRE2"
 fi
 
+# ./build.sh bench builds the standalone benchmarks in bench/ instead of the plugin.
+if [ "$1" == "bench" ]; then
+    for b in hash_table_bench threadpool_bench; do
+        gcc -o bench/${b} bench/${b}.c -g -O3 -lpthread || exit 1
+    done
+
+    # These include crapport.c. The yed code they never reach is garbage collected, so yed isn't linked.
+    YED_CFLAGS="$(yed --print-cflags | sed 's/-shared//g')"
+    for b in value_bench uring_bench props_bench; do
+        gcc -o bench/${b} bench/${b}.c ${YED_CFLAGS} ${PCRE2_FLAGS} -g -O3 -ffunction-sections -fdata-sections -Wl,--gc-sections -lpthread -lm \
+            -Wno-null-pointer-subtraction -Wno-gnu-null-pointer-arithmetic || exit 1
+    done
+    exit 0
+fi
+
+# ./build.sh test builds and runs the tests in test/. Like the benchmarks above, they include crapport.c.
+if [ "$1" == "test" ]; then
+    YED_CFLAGS="$(yed --print-cflags | sed 's/-shared//g')"
+    for t in watch_test value_test id_test; do
+        gcc -o test/${t} test/${t}.c ${YED_CFLAGS} ${PCRE2_FLAGS} -g -O1 -ffunction-sections -fdata-sections -Wl,--gc-sections -lpthread -lm \
+            -Wno-null-pointer-subtraction -Wno-gnu-null-pointer-arithmetic || exit 1
+        ./test/${t} || exit 1
+    done
+    exit 0
+fi
+
 gcc -o crapport.so crapport.c $(yed --print-cflags --print-ldflags) ${PCRE2_FLAGS} -g -O3 -Wno-null-pointer-subtraction -Wno-gnu-null-pointer-arithmetic
@@ -2,6 +2,9 @@
 
 #include <pthread.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <dirent.h>
 #ifdef __APPLE__
 #include <sys/param.h>
@@ -15,6 +18,11 @@
 #endif
 #include <libgen.h>
 #include <inttypes.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#endif
 
 #include <yed/plugin.h>
 #include <yed/syntax.h>
@@ -26,6 +34,9 @@
 #define THREADPOOL_IMPLEMENTATION
 #include "threadpool.h"
 
+#define URING_IMPLEMENTATION
+#include "uring.h"
+
 #define JULE_IMPL
 #include "jule.h"
 
@@ -68,7 +79,10 @@ do {                                                               \
 #define DEFAULT_CRAPPORT_DIR     ".crapport"
 #define DEFAULT_CRAPPORT_COLUMNS "benchmark run_config input_size exit_status runtime date ID"
 #define DEFAULT_JULE_FILE_NAME   "crapport.j"
+#define DEFAULT_SNAPSHOT_FILE    ".crapport-snapshot"
+#define DEFAULT_MAX_DEPTH        "4"
 #define BUFFER_NAME              "*crapport"
+#define POOL_STATS_BUFFER_NAME   "*crapport-pool-stats"
 
 
 
@@ -87,6 +101,7 @@ enum {
     STRING,
     NUMBER,
     BOOLEAN,
+    UNLOADED, /* Only in a Prop whose value was skipped. See crapport-projection. */
 };
 
 
@@ -102,13 +117,283 @@ static uint64_t str_hash(Str s) {
 }
 
 static int str_equ(Str a, Str b) { return strcmp(a, b) == 0; }
-use_hash_table(Str, Value);
-typedef hash_table(Str, Value) Value_Table;
 
+/*
+ * Load arena
+ *
+ * Strings that live exactly as long as one load -- interned keys and values
+ * and run names -- are carved out of large chunks, and free_all() releases
+ * those chunks wholesale instead of freeing every string. Each thread bump
+ * allocates from a chunk of its own and only takes arena_lock to get the next
+ * one. A thread notices that its chunk went away with the last load by its
+ * generation.
+ */
+
+#define ARENA_CHUNK_SIZE (256 * 1024)
+
+typedef struct {
+    u64   gen;
+    char *chunk;
+    u64   used;
+} Arena_Local;
+
+static pthread_mutex_t         arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static array_t                 arena_chunks; /* char* */
+static u64                     arena_gen  = 1;
+static u64                     arena_bytes;
+static __thread Arena_Local    arena_local;
+static pthread_mutex_t         arena_watch_lock = PTHREAD_MUTEX_INITIALIZER; /* Held while watch mode parses. */
+
+static void arena_init(void) {
+    arena_chunks = array_make(char*);
+}
+
+static void arena_adopt(char *mem, u64 size) {
+    pthread_mutex_lock(&arena_lock);
+    array_push(arena_chunks, mem);
+    arena_bytes += size;
+    pthread_mutex_unlock(&arena_lock);
+}
+
+/* Not aligned: only strings live here. */
+static char *arena_strndup(const char *s, int len) {
+    Arena_Local *l;
+    char        *mem;
+
+    l = &arena_local;
+
+    if (len + 1 > ARENA_CHUNK_SIZE / 4) {
+        mem = malloc(len + 1);
+        arena_adopt(mem, len + 1);
+    } else {
+        if (l->gen != __atomic_load_n(&arena_gen, __ATOMIC_ACQUIRE)
+        ||  l->used + len + 1 > ARENA_CHUNK_SIZE) {
+
+            l->gen   = __atomic_load_n(&arena_gen, __ATOMIC_ACQUIRE);
+            l->chunk = malloc(ARENA_CHUNK_SIZE);
+            l->used  = 0;
+            arena_adopt(l->chunk, ARENA_CHUNK_SIZE);
+        }
+        mem      = l->chunk + l->used;
+        l->used += len + 1;
+    }
+
+    memcpy(mem, s, len);
+    mem[len] = 0;
+
+    return mem;
+}
+
+static inline char *arena_strdup(const char *s) { return arena_strndup(s, strlen(s)); }
+
+/* Nothing may allocate from the arena while this runs. */
+static void arena_free_all(void) {
+    char **chunk;
+
+    pthread_mutex_lock(&arena_lock);
+
+    DBG("arena: releasing %d chunks, %"PRIu64" KB", array_len(arena_chunks), arena_bytes / 1024);
+
+    array_traverse(arena_chunks, chunk) { free(*chunk); }
+    array_clear(arena_chunks);
+    arena_bytes = 0;
+
+    __atomic_add_fetch(&arena_gen, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&arena_lock);
+}
+
+/*
+ * String interning
+ *
+ * Every key and string value in an experiment comes from this pool, so each
+ * distinct string is stored once per load and two interned strings are equal
+ * iff their pointers are. The pool is sharded by hash so that loader threads
+ * rarely contend. The strings themselves live in the load arena.
+ */
+
+#define INTERN_SHARDS     (64)
+
+typedef struct {
+    u64  hash;
+    Str  str;
+} Intern_Entry;
+
+typedef struct {
+    pthread_mutex_t  lock;
+    Intern_Entry    *entries;
+    u64              cap;
+    u64              len;
+} Intern_Shard;
+
+static Intern_Shard intern_shards[INTERN_SHARDS];
+
+static inline u64 str_hash_n(const char *s, int len) {
+    u64 hash = 5381;
+    int i;
+
+    for (i = 0; i < len; i += 1) {
+        hash = ((hash << 5) + hash) + (unsigned char)s[i];
+    }
+
+    return hash;
+}
+
+static void intern_init(void) {
+    int i;
+
+    for (i = 0; i < INTERN_SHARDS; i += 1) {
+        memset(&intern_shards[i], 0, sizeof(intern_shards[i]));
+        pthread_mutex_init(&intern_shards[i].lock, NULL);
+    }
+}
+
+/* The strings go with the arena. */
+static void intern_free_all(void) {
+    Intern_Shard *shard;
+    int           i;
+
+    for (i = 0; i < INTERN_SHARDS; i += 1) {
+        shard = &intern_shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+
+        free(shard->entries);
+
+        shard->entries = NULL;
+        shard->cap     = 0;
+        shard->len     = 0;
+
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+static void intern_grow(Intern_Shard *shard) {
+    Intern_Entry *old;
+    u64           old_cap;
+    u64           i;
+    u64           j;
+
+    old     = shard->entries;
+    old_cap = shard->cap;
+
+    shard->cap     = old_cap ? old_cap * 2 : 256;
+    shard->entries = calloc(shard->cap, sizeof(Intern_Entry));
+
+    for (i = 0; i < old_cap; i += 1) {
+        if (old[i].str == NULL) { continue; }
+        for (j = (old[i].hash >> 6) & (shard->cap - 1); shard->entries[j].str != NULL; j = (j + 1) & (shard->cap - 1));
+        shard->entries[j] = old[i];
+    }
+
+    free(old);
+}
+
+/* Only hashes shard and slot off of the same hash in different bits. */
+static Str intern_lookup(const char *s, int len, int insert) {
+    u64           hash;
+    Intern_Shard *shard;
+    u64           i;
+    Intern_Entry *e;
+    Str           result;
+
+    hash  = str_hash_n(s, len);
+    shard = &intern_shards[hash & (INTERN_SHARDS - 1)];
+
+    pthread_mutex_lock(&shard->lock);
+
+    result = NULL;
+
+    if (shard->entries == NULL) {
+        if (!insert) { goto out_unlock; }
+        intern_grow(shard);
+    }
+
+    for (i = (hash >> 6) & (shard->cap - 1);; i = (i + 1) & (shard->cap - 1)) {
+        e = shard->entries + i;
+        if (e->str == NULL) { break; }
+        if (e->hash == hash && strncmp(e->str, s, len) == 0 && e->str[len] == 0) {
+            result = e->str;
+            goto out_unlock;
+        }
+    }
+
+    if (!insert) { goto out_unlock; }
+
+    e->hash = hash;
+    e->str  = result = arena_strndup(s, len);
+
+    shard->len += 1;
+    if (shard->len * 4 >= shard->cap * 3) {
+        intern_grow(shard);
+    }
+
+out_unlock:;
+    pthread_mutex_unlock(&shard->lock);
+
+    return result;
+}
+
+static inline Str intern_n(const char *s, int len) { return intern_lookup(s, len, 1);         }
+static inline Str intern(Str s)                     { return intern_lookup(s, strlen(s), 1);    }
+static inline Str intern_find(Str s)                { return intern_lookup(s, strlen(s), 0);    }
+
+/* Hash and equality for tables whose keys are all interned. */
+static uint64_t intern_hash(Str s) { return ((u64)(uintptr_t)s * 0x9E3779B97F4A7C15ULL) >> 17; }
+static int      intern_equ(Str a, Str b) { return a == b; }
+
+use_flat_hash_table(Index_Table, Str, int, intern_hash, intern_equ);
+use_flat_hash_table(Name_Index,  Str, int, str_hash,    str_equ);
+
+/* IDs are hashes already, but the table wants the high bits mixed too. */
+static uint64_t id_hash(u64 id)        { return id * 0x9E3779B97F4A7C15ULL; }
+static int      id_equ(u64 a, u64 b)   { return a == b; }
+
+use_flat_hash_table(Id_Index, u64, int, id_hash, id_equ);
+
+typedef struct {
+    Str   key; /* Interned. */
+    Value val;
+} Prop;
+
+#define EXP_INLINE_PROPS (8)
+
+/*
+ * A single parsed run, before it's added to the store. Props are in file
+ * order and later duplicates win. Runs with up to EXP_INLINE_PROPS of them
+ * don't allocate; see exp_push().
+ */
 typedef struct {
-    Value_Table props;
+    int          n_props;
+    Prop         inline_props[EXP_INLINE_PROPS];
+    array_t      spill; /* Prop. All of them, once there are more than EXP_INLINE_PROPS. */
+    char        *name;  /* Run directory, relative to crapport-dir, or see aggregate_name(). */
+    u64          mtime; /* mtime of <run>/props in ns. */
 } Experiment;
 
+/*
+ * Loaded experiments are stored by column: one dense vector of values per
+ * key, indexed by row, plus a bitmap of the rows that actually have the key.
+ * A column may be shorter than the store; rows past its end are absent.
+ */
+typedef struct {
+    Str      key;      /* Interned. */
+    array_t  values;   /* Value, indexed by row. */
+    array_t  present;  /* u64 bitmap words. */
+    int      width;    /* Display width over the working rows, or -1. Set by update_buffer(). */
+    int      unloaded; /* Some rows have the key, but crapport-projection skipped its values. */
+    int      pending;  /* Unloaded, and a projection job is loading it. */
+} Column;
+
+typedef struct {
+    array_t      columns; /* Column */
+    Index_Table  by_key;  /* interned key -> index into columns */
+    Id_Index     by_id;   /* ID -> row */
+    array_t      names;   /* char*, run directory of each row */
+    array_t      mtimes;  /* u64, props mtime of each row */
+    int          n_rows;
+} Exp_Store;
+
 enum {
     PLOT_SCATTER = 0,
     PLOT_LINE,
@@ -154,12 +439,13 @@ typedef struct {
 } Plot_Point;
 
 static yed_plugin        *Self;
-static array_t            experiments;
-static array_t            experiments_working;
+static Exp_Store          store;
+static array_t            experiments_working; /* int, rows of store */
 static pthread_mutex_t    experiments_lock = PTHREAD_MUTEX_INITIALIZER;
-static Experiment         layout;
-static Experiment         working_layout;
-static tp_t              *tp;
+static Name_Index         exp_index;
+static tp_t              *pool;       /* Shared by all background work. See get_pool(). */
+static u64                pool_start_ms;
+static tp_group_t        *load_group; /* The tasks of the load in flight. */
 static int                loading;
 static yed_syntax         syn;
 static TGE_Game          *tge;
@@ -182,235 +468,3250 @@ static int                err_line;
 static int                err_col;
 static int                err_has_loc;
 
-static void init_exp(Experiment *exp) {
-    exp->props = hash_table_make_e(Str, Value, str_hash, str_equ);
+static void init_exp(Experiment *exp) {
+    exp->n_props = 0;
+    exp->name    = NULL;
+    exp->mtime   = 0;
+}
+
+/* Props in the last run this thread spilled, so that the next one like it allocates once. */
+static __thread int exp_spill_hint;
+
+static inline Prop *exp_props(Experiment *exp) {
+    return exp->n_props > EXP_INLINE_PROPS ? (Prop*)array_data(exp->spill) : exp->inline_props;
+}
+
+#define exp_traverse(exp, it) \
+    for ((it) = exp_props(exp); (it) < exp_props(exp) + (exp)->n_props; (it) += 1)
+
+static inline void exp_push(Experiment *exp, Prop *prop) {
+    if (exp->n_props < EXP_INLINE_PROPS) {
+        exp->inline_props[exp->n_props] = *prop;
+        exp->n_props += 1;
+        return;
+    }
+
+    if (exp->n_props == EXP_INLINE_PROPS) {
+        exp->spill = array_make_with_cap(Prop, MAX(2 * EXP_INLINE_PROPS, exp_spill_hint));
+        array_push_n(exp->spill, exp->inline_props, EXP_INLINE_PROPS);
+    }
+
+    array_push(exp->spill, *prop);
+    exp->n_props   += 1;
+    exp_spill_hint  = exp->n_props;
+}
+
+static void free_exp(Experiment *exp) {
+    /* Keys, strings and the name belong to the load arena. */
+    if (exp->n_props > EXP_INLINE_PROPS) {
+        array_free(exp->spill);
+    }
+    exp->n_props = 0;
+    exp->name    = NULL;
+}
+
+static inline Value *column_get(Column *col, int row) {
+    if (row >= array_len(col->values))                                      { return NULL; }
+    if (!(((u64*)array_data(col->present))[row >> 6] & (1ULL << (row & 63)))) { return NULL; }
+
+    return array_item(col->values, row);
+}
+
+static void column_set(Column *col, int row, Value val) {
+    Value zero;
+    u64   word;
+
+    memset(&zero, 0, sizeof(zero));
+    word = 0;
+
+    while (array_len(col->values) <= row)         { array_push(col->values, zero);  }
+    while (array_len(col->present) <= (row >> 6)) { array_push(col->present, word); }
+
+    *(Value*)array_item(col->values, row)          = val;
+    ((u64*)array_data(col->present))[row >> 6] |= 1ULL << (row & 63);
+}
+
+static void column_unset(Column *col, int row) {
+    if (row >= array_len(col->values)) { return; }
+
+    ((u64*)array_data(col->present))[row >> 6] &= ~(1ULL << (row & 63));
+}
+
+/* Shape of the last store freed. A reload is usually the same size, so the next store starts there. */
+static int store_prev_rows;
+static int store_prev_cols;
+
+static void store_init(Exp_Store *s) {
+    s->columns = array_make_with_cap(Column, MAX(store_prev_cols, 1));
+    s->by_key  = flat_hash_table_make(Index_Table);
+    s->by_id   = flat_hash_table_make(Id_Index);
+    s->names   = array_make_with_cap(char*, MAX(store_prev_rows, 1));
+    s->mtimes  = array_make_with_cap(u64, MAX(store_prev_rows, 1));
+    s->n_rows  = 0;
+
+    flat_hash_table_reserve(Index_Table, s->by_key, store_prev_cols);
+    flat_hash_table_reserve(Id_Index,    s->by_id,  store_prev_rows);
+}
+
+/* Gives back whatever store_init() reserved that this load didn't use. */
+static void store_shrink(Exp_Store *s) {
+    flat_hash_table_shrink_to_fit(Index_Table, s->by_key);
+    flat_hash_table_shrink_to_fit(Id_Index,    s->by_id);
+}
+
+/* Names are in the load arena, so this is O(columns), not O(rows). */
+static void store_free(Exp_Store *s) {
+    Column *col;
+
+    if (s->by_key == NULL) { return; }
+
+    store_prev_rows = s->n_rows;
+    store_prev_cols = array_len(s->columns);
+
+    array_traverse(s->columns, col) {
+        array_free(col->values);
+        array_free(col->present);
+    }
+    array_free(s->columns);
+
+    flat_hash_table_free(Index_Table, s->by_key);
+    flat_hash_table_free(Id_Index, s->by_id);
+    s->by_key = NULL;
+    s->by_id  = NULL;
+
+    array_free(s->names);
+    array_free(s->mtimes);
+
+    s->n_rows = 0;
+}
+
+/* The returned column is only valid until another one is created. */
+static Column *store_column(Exp_Store *s, Str key, int create) {
+    int    *lookup;
+    int     idx;
+    Column  col;
+
+    if (s->by_key == NULL) { return NULL; }
+
+    if ((lookup = flat_hash_table_get_val(Index_Table, s->by_key, key)) != NULL) {
+        return array_item(s->columns, *lookup);
+    }
+
+    if (!create) { return NULL; }
+
+    col.key      = key;
+    col.values   = array_make(Value);
+    col.present  = array_make(u64);
+    col.width    = -1;
+    col.unloaded = 0;
+    col.pending  = 0;
+
+    idx = array_len(s->columns);
+    array_push(s->columns, col);
+    flat_hash_table_insert(Index_Table, s->by_key, key, idx);
+
+    return array_item(s->columns, idx);
+}
+
+static inline Value *store_get(Exp_Store *s, int row, Str key) {
+    Column *col;
+
+    if ((col = store_column(s, key, 0)) == NULL) { return NULL; }
+
+    return column_get(col, row);
+}
+
+static void store_set_props(Exp_Store *s, int row, Experiment *exp) {
+    Prop   *prop;
+    Column *col;
+
+    exp_traverse(exp, prop) {
+        col = store_column(s, prop->key, 1);
+        if (prop->val.type == UNLOADED) {
+            col->unloaded = 1;
+        } else {
+            column_set(col, row, prop->val);
+        }
+    }
+}
+
+/* The caller still frees the props. */
+static int store_add_row(Exp_Store *s, Experiment *exp) {
+    int row;
+
+    row = s->n_rows;
+
+    array_push(s->names,  exp->name);
+    array_push(s->mtimes, exp->mtime);
+
+    /* epump() peeks at this without the lock while loading. */
+    __atomic_store_n(&s->n_rows, row + 1, __ATOMIC_RELAXED);
+
+    store_set_props(s, row, exp);
+
+    return row;
+}
+
+/* Like store_add_row(), but overwrites an existing row. Keys in skip are kept. */
+static void store_replace_row(Exp_Store *s, int row, Experiment *exp, Str skip) {
+    Column *col;
+
+    array_traverse(s->columns, col) {
+        if (col->key != skip) { column_unset(col, row); }
+    }
+
+    *(char**)array_item(s->names, row) = exp->name;
+
+    *(u64*)array_item(s->mtimes, row) = exp->mtime;
+
+    store_set_props(s, row, exp);
+}
+
+/*
+ * A row's ID only depends on its name, so it survives reloads, refreshes and
+ * whatever order the loader finished in. The row index is still the dense
+ * handle everything else uses; by_id maps back to it.
+ *
+ * IDs are still NUMBERs, but 48-bit hashes instead of counting up in load
+ * order. A double holds them exactly, so they round-trip through Jule, and
+ * they're shown in full rather than with %g.
+ */
+static u64 exp_id_hash(Str name, u64 salt) {
+    u64 h;
+
+    h = 0xcbf29ce484222325ULL ^ (salt * 0x9E3779B97F4A7C15ULL);
+    for (; *name; name += 1) {
+        h ^= (unsigned char)*name;
+        h *= 0x100000001b3ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h >> 16;
+}
+
+/* The salt that gave name the ID id. */
+static u64 exp_id_salt(Str name, u64 id) {
+    u64 salt;
+
+    for (salt = 0; exp_id_hash(name, salt) != id; salt += 1) {}
+
+    return salt;
+}
+
+static void store_set_id(Exp_Store *s, int row, Str ID) {
+    Column *col;
+    Str     name;
+    Str     other_name;
+    u64     salt;
+    u64     h;
+    int    *lookup;
+    int     other;
+    Value   id;
+
+    col     = store_column(s, ID, 1);
+    id.type = NUMBER;
+    salt    = 0;
+
+    /*
+     * 48 bits make a collision unlikely, not impossible. Of a colliding pair,
+     * the name that sorts first keeps the ID and the other one tries its next
+     * salt, so who ends up with which ID doesn't depend on which row arrived
+     * first.
+     */
+    for (;;) {
+        name = *(char**)array_item(s->names, row);
+
+        h = exp_id_hash(name, salt);
+
+        if ((lookup = flat_hash_table_get_val(Id_Index, s->by_id, h)) == NULL) { break; }
+
+        other      = *lookup;
+        other_name = *(char**)array_item(s->names, other);
+
+        if (strcmp(name, other_name) < 0) {
+            *lookup   = row;
+            id.number = (double)h;
+            column_set(col, row, id);
+
+            row  = other;
+            salt = exp_id_salt(other_name, h) + 1;
+        } else {
+            salt += 1;
+        }
+    }
+
+    id.number = (double)h;
+    flat_hash_table_insert(Id_Index, s->by_id, h, row);
+    column_set(col, row, id);
+}
+
+static int store_has_unloaded(Exp_Store *s) {
+    Column *col;
+
+    array_traverse(s->columns, col) {
+        if (col->unloaded) { return 1; }
+    }
+
+    return 0;
+}
+
+static void load_chunks_free(void);
+static void projection_cancel(void);
+static void projection_free(void);
+
+static void free_all(void) {
+    DBG("tearing down existing tables");
+
+    /* Watch mode parses into the arena without experiments_lock. */
+    pthread_mutex_lock(&arena_watch_lock);
+    pthread_mutex_lock(&experiments_lock);
+
+    store_free(&store);
+    array_free(experiments_working);
+
+    if (exp_index != NULL) {
+        flat_hash_table_free(Name_Index, exp_index);
+        exp_index = NULL;
+    }
+
+    load_chunks_free();
+    projection_cancel();
+    projection_free();
+
+    intern_free_all();
+    arena_free_all();
+
+    pthread_mutex_unlock(&experiments_lock);
+    pthread_mutex_unlock(&arena_watch_lock);
+}
+
+static Str get_crapport_dir(void) {
+    Str dir;
+
+    if ((dir = yed_get_var("crapport-dir")) == NULL) {
+        dir = DEFAULT_CRAPPORT_DIR;
+    }
+
+    return dir;
+}
+
+/*
+ * Value classification
+ *
+ * Every value of a load goes through parse_value(), so it decides on a type
+ * from the first byte and then makes one pass over the value. Booleans are
+ * exactly the spellings in boolean_spellings. Numbers are whatever strtod()
+ * accepts in full, which includes the empty string, so an empty value is 0
+ * as it always was. Plain decimals that fit in 19 digits are
+ * converted without strtod() whenever a single multiply or divide by a power
+ * of ten is exact (Clinger's fast path); everything else still goes through
+ * strtod(), so the results are identical.
+ */
+
+static const struct {
+    const char *spellings[3];
+    int         len;
+    int         value;
+} boolean_spellings[] = {
+    { { "true",  "True",  "TRUE"  }, 4, 1 },
+    { { "yes",   "Yes",   "YES"   }, 3, 1 },
+    { { "on",    "On",    "ON"    }, 2, 1 },
+    { { "false", "False", "FALSE" }, 5, 0 },
+    { { "no",    "No",    "NO"    }, 2, 0 },
+    { { "off",   "Off",   "OFF"   }, 3, 0 },
+};
+
+static const double exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* Returns 1 or 0, or -1 if str isn't a boolean. */
+static inline int parse_boolean(Str str, int len) {
+    unsigned i;
+    int      j;
+
+    for (i = 0; i < sizeof(boolean_spellings) / sizeof(boolean_spellings[0]); i += 1) {
+        if (boolean_spellings[i].len != len) { continue; }
+
+        for (j = 0; j < 3; j += 1) {
+            if (str[0] == boolean_spellings[i].spellings[j][0]
+            &&  memcmp(str, boolean_spellings[i].spellings[j], len) == 0) {
+
+                return boolean_spellings[i].value;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static inline int is_strtod_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int parse_number_slow(Str str, int len, double *d) {
+    char  buff[64];
+    char *copy;
+    char *end;
+    int   ok;
+
+    /* str isn't NUL-terminated and strtod() needs it to be. */
+    copy = len < (int)sizeof(buff) ? buff : malloc(len + 1);
+    memcpy(copy, str, len);
+    copy[len] = 0;
+
+    *d = strtod(copy, &end);
+    ok = end == copy + len;
+
+    if (copy != buff) { free(copy); }
+
+    return ok;
+}
+
+static inline int parse_number(Str str, int len, double *d) {
+    const char *p;
+    const char *end;
+    int         neg;
+    u64         mant;
+    int         n_sig;
+    int         n_digits;
+    int         exp;
+    int         exp_neg;
+    int         e;
+
+    if (len >= 64) { return parse_number_slow(str, len, d); }
+
+    p   = str;
+    end = str + len;
+    neg = 0;
+
+    if (*p == '+' || *p == '-') {
+        neg  = *p == '-';
+        p   += 1;
+    }
+
+    mant     = 0;
+    n_sig    = 0;
+    n_digits = 0;
+    exp      = 0;
+
+    for (; p < end && *p >= '0' && *p <= '9'; p += 1) {
+        if (n_sig == 19) { return parse_number_slow(str, len, d); }
+        mant      = mant * 10 + (*p - '0');
+        n_sig    += mant != 0;
+        n_digits += 1;
+    }
+
+    if (p < end && *p == '.') {
+        for (p += 1; p < end && *p >= '0' && *p <= '9'; p += 1) {
+            if (n_sig == 19) { return parse_number_slow(str, len, d); }
+            mant      = mant * 10 + (*p - '0');
+            n_sig    += mant != 0;
+            n_digits += 1;
+            exp      -= 1;
+        }
+    }
+
+    if (n_digits == 0) {
+        /* Only strtod() knows about inf, nan and leading space. */
+        if ((end - p >= 3 && (strncasecmp(p, "inf", 3) == 0 || strncasecmp(p, "nan", 3) == 0))
+        ||  is_strtod_space(*str)) {
+
+            return parse_number_slow(str, len, d);
+        }
+        return 0;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p       += 1;
+        exp_neg  = 0;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_neg  = *p == '-';
+            p       += 1;
+        }
+
+        if (p >= end || *p < '0' || *p > '9') { return 0; }
+
+        for (e = 0; p < end && *p >= '0' && *p <= '9'; p += 1) {
+            if (e < 100000) { e = e * 10 + (*p - '0'); }
+        }
+
+        exp += exp_neg ? -e : e;
+    }
+
+    /* Hex floats. */
+    if (p < end) {
+        return (*p == 'x' || *p == 'X') ? parse_number_slow(str, len, d) : 0;
+    }
+
+    if (mant == 0) {
+        *d = neg ? -0.0 : 0.0;
+        return 1;
+    }
+
+    if (mant > (1ULL << 53) || exp < -22 || exp > 22) { return parse_number_slow(str, len, d); }
+
+    *d = exp < 0 ? (double)mant / exact_pow10[-exp] : (double)mant * exact_pow10[exp];
+    if (neg) { *d = -*d; }
+
+    return 1;
+}
+
+static inline Value parse_value(Str str, int len) {
+    Value val;
+    int   b;
+
+    if (len == 0) {
+        val.type   = NUMBER;
+        val.number = 0.0;
+        goto out;
+    }
+
+    switch (str[0]) {
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+        case '+': case '-': case '.':
+            break;
+        case 't': case 'T': case 'y': case 'Y': case 'o': case 'O':
+        case 'f': case 'F': case 'n': case 'N':
+            if ((b = parse_boolean(str, len)) >= 0) {
+                val.type    = BOOLEAN;
+                val.boolean = b;
+                goto out;
+            }
+            /* "nan" */
+            if (str[0] != 'n' && str[0] != 'N') { goto out_string; }
+            break;
+        case 'i': case 'I':
+        case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+            break;
+        default:
+            goto out_string;
+    }
+
+    if (parse_number(str, len, &val.number)) {
+        val.type = NUMBER;
+        goto out;
+    }
+
+out_string:;
+    val.type   = STRING;
+    val.string = intern_n(str, len);
+
+out:;
+    return val;
+}
+
+/*
+ * Snapshot cache
+ *
+ * After a successful load, every experiment is written to a single file so
+ * that the next load can skip opening and parsing any run whose props file
+ * hasn't changed. The file is laid out as:
+ *
+ *     Snapshot_Header
+ *     string blob     (NUL-terminated strings, referenced by byte offset)
+ *     rows            (Snapshot_Row followed by n_props Snapshot_Props, each)
+ *
+ * It's mmap'd read-only during a load and looked up by run directory name.
+ * The version also changes when values would be classified differently.
+ */
+
+#define SNAPSHOT_MAGIC   "CRAPSNAP"
+#define SNAPSHOT_VERSION (2)
+
+typedef struct {
+    char magic[8];
+    u32  version;
+    u32  n_rows;
+    u64  strings_size;
+    u64  size;
+} Snapshot_Header;
+
+typedef struct {
+    u32 name;
+    u32 n_props;
+    u64 mtime;
+} Snapshot_Row;
+
+typedef struct {
+    u32 key;
+    u32 type;
+    union {
+        u64    string;
+        double number;
+        u64    boolean;
+    };
+} Snapshot_Prop;
+
+typedef Snapshot_Row *Snapshot_Row_Ptr;
+use_flat_hash_table(Snapshot_Table, Str, Snapshot_Row_Ptr, str_hash, str_equ);
+
+typedef u32 Str_Offset;
+use_flat_hash_table(Offset_Table, Str, Str_Offset, str_hash, str_equ);
+
+static char            load_root[1024];
+static int             load_root_len;
+static void           *snapshot_addr;
+static u64             snapshot_size;
+static const char     *snapshot_strings;
+static Snapshot_Table  snapshot_rows;
+static u32             snapshot_n_rows;
+static char            snapshot_path[1024];
+static char            snapshot_status[1280];
+static int             n_reparsed;
+static Index_Table     load_needed; /* Interned keys whose values are parsed, or NULL for all. */
+
+static inline int key_needed(Index_Table needed, Str key) {
+    return needed == NULL || flat_hash_table_get_val(Index_Table, needed, key) != NULL;
+}
+
+/* Like mkdir -p. Returns 0 if path isn't a directory afterwards. */
+static int make_dirs(char *path) {
+    struct stat  st;
+    char        *p;
+
+    for (p = path + 1; *p; p += 1) {
+        if (*p != '/') { continue; }
+        *p = 0;
+        mkdir(path, 0700);
+        *p = '/';
+    }
+    mkdir(path, 0700);
+    errno = 0;
+
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/*
+ * By default, snapshots go in $XDG_CACHE_HOME/crapport (or ~/.cache/crapport),
+ * named by a hash of the real path of crapport-dir, so that loading results
+ * never writes into the results directory. Without either, or if the cache
+ * directory can't be made, it's DEFAULT_SNAPSHOT_FILE in crapport-dir.
+ */
+static void get_snapshot_path(char *buff, int size) {
+    Str   path;
+    Str   cache;
+    char  dir[1024];
+    char *real;
+
+    if ((path = yed_get_var("crapport-snapshot-file")) != NULL) {
+        snprintf(buff, size, "%s", path);
+        return;
+    }
+
+    dir[0] = 0;
+    if ((cache = getenv("XDG_CACHE_HOME")) != NULL && cache[0] == '/') {
+        snprintf(dir, sizeof(dir), "%s/crapport", cache);
+    } else if ((cache = getenv("HOME")) != NULL && cache[0] == '/') {
+        snprintf(dir, sizeof(dir), "%s/.cache/crapport", cache);
+    }
+
+    if (!dir[0] || !make_dirs(dir)) {
+        snprintf(buff, size, "%s/%s", get_crapport_dir(), DEFAULT_SNAPSHOT_FILE);
+        return;
+    }
+
+    real = realpath(get_crapport_dir(), NULL);
+    errno = 0;
+
+    snprintf(buff, size, "%s/%016"PRIx64, dir, (u64)str_hash(real != NULL ? real : get_crapport_dir()));
+
+    free(real);
+}
+
+static void snapshot_close(void) {
+    if (snapshot_rows != NULL) {
+        flat_hash_table_free(Snapshot_Table, snapshot_rows);
+        snapshot_rows = NULL;
+    }
+
+    if (snapshot_addr != NULL) {
+        munmap(snapshot_addr, snapshot_size);
+        snapshot_addr = NULL;
+    }
+
+    snapshot_size    = 0;
+    snapshot_strings = NULL;
+    snapshot_n_rows  = 0;
+}
+
+/*
+ * Nothing in a snapshot is trusted until it's checked here: every string
+ * offset is inside the blob, which ends in a NUL, and every row and its props
+ * are inside the file. snapshot_load_exp() relies on that.
+ */
+static int snapshot_row_ok(Snapshot_Row *row, u64 strings_size) {
+    Snapshot_Prop *prop;
+    u32            i;
+
+    if (row->name >= strings_size) { return 0; }
+
+    prop = (Snapshot_Prop*)(row + 1);
+    for (i = 0; i < row->n_props; i += 1, prop += 1) {
+        if (prop->key >= strings_size) { return 0; }
+
+        switch (prop->type) {
+            case STRING:  if (prop->string >= strings_size) { return 0; } break;
+            case NUMBER:                                                  break;
+            case BOOLEAN:                                                 break;
+            default:      return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void snapshot_open(Str path) {
+    int              fd;
+    struct stat      st;
+    Snapshot_Header *header;
+    char            *p;
+    char            *end;
+    Snapshot_Row    *row;
+    u32              i;
+
+    snapshot_close();
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        DBG("no snapshot at '%s'", path);
+        errno = 0;
+        goto out;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Snapshot_Header)) { goto out_close; }
+
+    snapshot_size = st.st_size;
+    snapshot_addr = mmap(NULL, snapshot_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (snapshot_addr == MAP_FAILED) {
+        snapshot_addr = NULL;
+        goto out_close;
+    }
+
+    header = snapshot_addr;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+    ||  header->version      != SNAPSHOT_VERSION
+    ||  header->size         != snapshot_size
+    ||  header->strings_size >  snapshot_size - sizeof(*header)
+    ||  (header->strings_size & 7)
+    ||  (header->strings_size > 0 && ((char*)snapshot_addr)[sizeof(*header) + header->strings_size - 1] != 0)) {
+
+        DBG("snapshot '%s' is stale or corrupt -- ignoring it", path);
+        snapshot_close();
+        goto out_close;
+    }
+
+    snapshot_strings = (char*)snapshot_addr + sizeof(*header);
+    snapshot_n_rows  = header->n_rows;
+    snapshot_rows    = flat_hash_table_make(Snapshot_Table);
+
+    /* n_rows sizes the table, so it has to fit in the file before it's believed. */
+    if ((u64)header->n_rows * sizeof(Snapshot_Row) > snapshot_size - sizeof(*header) - header->strings_size) {
+        DBG("snapshot '%s' is truncated or corrupt -- ignoring it", path);
+        snapshot_close();
+        goto out_close;
+    }
+
+    flat_hash_table_reserve(Snapshot_Table, snapshot_rows, header->n_rows);
+
+    p   = (char*)snapshot_strings + header->strings_size;
+    end = (char*)snapshot_addr + snapshot_size;
+    for (i = 0; i < header->n_rows; i += 1) {
+        row = (Snapshot_Row*)p;
+        if ((u64)(end - p) < sizeof(*row)
+        ||  (u64)(end - p) - sizeof(*row) < (u64)row->n_props * sizeof(Snapshot_Prop)
+        ||  !snapshot_row_ok(row, header->strings_size)) {
+
+            DBG("snapshot '%s' is truncated or corrupt -- ignoring it", path);
+            snapshot_close();
+            goto out_close;
+        }
+        flat_hash_table_insert(Snapshot_Table, snapshot_rows, snapshot_strings + row->name, row);
+        p += sizeof(*row) + row->n_props * sizeof(Snapshot_Prop);
+    }
+
+    DBG("mapped snapshot '%s' with %u rows", path, snapshot_n_rows);
+
+out_close:;
+    close(fd);
+out:;
+}
+
+static int snapshot_load_exp(Experiment *exp) {
+    Snapshot_Row_Ptr *lookup;
+    Snapshot_Row     *row;
+    Snapshot_Prop    *prop;
+    u32               i;
+    Prop              p;
+
+    if (snapshot_rows == NULL)                                            { return 0; }
+    if ((lookup = flat_hash_table_get_val(Snapshot_Table, snapshot_rows, exp->name)) == NULL) { return 0; }
+
+    row = *lookup;
+    if (row->mtime != exp->mtime) { return 0; }
+
+    prop = (Snapshot_Prop*)(row + 1);
+    for (i = 0; i < row->n_props; i += 1, prop += 1) {
+        p.key      = intern(snapshot_strings + prop->key);
+        p.val.type = key_needed(load_needed, p.key) ? prop->type : UNLOADED;
+        switch (p.val.type) {
+            case STRING:  p.val.string  = intern(snapshot_strings + prop->string); break;
+            case NUMBER:  p.val.number  = prop->number;                            break;
+            case BOOLEAN: p.val.boolean = prop->boolean;                           break;
+        }
+        exp_push(exp, &p);
+    }
+
+    return 1;
+}
+
+static u32 snapshot_intern(Offset_Table offsets, array_t *strings, Str s) {
+    Str_Offset *lookup;
+    Str_Offset  off;
+
+    if ((lookup = flat_hash_table_get_val(Offset_Table, offsets, s)) != NULL) { return *lookup; }
+
+    off = array_len(*strings);
+    array_push_n(*strings, (char*)s, strlen(s) + 1);
+    flat_hash_table_insert(Offset_Table, offsets, s, off);
+
+    return off;
+}
+
+/* A snapshot as it will be written, copied out of the store. */
+typedef struct {
+    Snapshot_Header header;
+    array_t         strings;
+    array_t         rows;
+} Snapshot_Image;
+
+/* Runs on the load monitor thread with experiments_lock held. */
+static void snapshot_serialize(Snapshot_Image *image) {
+    Offset_Table                 offsets;
+    Str                          ID;
+    int                          r;
+    char                        *name;
+    Column                      *col;
+    Value                       *val;
+    Snapshot_Row                 row;
+    Snapshot_Prop                prop;
+    char                         zero[8];
+    u64                          pad;
+
+    offsets        = flat_hash_table_make(Offset_Table);
+    image->strings = array_make(char);
+    image->rows    = array_make(char);
+
+    /* Every name is distinct, so there are at least this many strings. */
+    flat_hash_table_reserve(Offset_Table, offsets, store.n_rows + array_len(store.columns));
+
+    ID = intern("ID");
+
+    for (r = 0; r < store.n_rows; r += 1) {
+        name = *(char**)array_item(store.names, r);
+
+        row.name    = snapshot_intern(offsets, &image->strings, name);
+        row.n_props = 0;
+        row.mtime   = *(u64*)array_item(store.mtimes, r);
+
+        array_traverse(store.columns, col) {
+            if (col->key != ID && column_get(col, r) != NULL) { row.n_props += 1; }
+        }
+
+        array_push_n(image->rows, (char*)&row, sizeof(row));
+
+        array_traverse(store.columns, col) {
+            if (col->key == ID)                        { continue; }
+            if ((val = column_get(col, r)) == NULL) { continue; }
+
+            memset(&prop, 0, sizeof(prop));
+            prop.key  = snapshot_intern(offsets, &image->strings, col->key);
+            prop.type = val->type;
+            switch (val->type) {
+                case STRING:  prop.string  = snapshot_intern(offsets, &image->strings, val->string); break;
+                case NUMBER:  prop.number  = val->number;                                            break;
+                case BOOLEAN: prop.boolean = val->boolean;                                           break;
+            }
+            array_push_n(image->rows, (char*)&prop, sizeof(prop));
+        }
+    }
+
+    memset(zero, 0, sizeof(zero));
+    pad = (8 - (array_len(image->strings) & 7)) & 7;
+    array_push_n(image->strings, zero, pad);
+
+    memset(&image->header, 0, sizeof(image->header));
+    memcpy(image->header.magic, SNAPSHOT_MAGIC, sizeof(image->header.magic));
+    image->header.version      = SNAPSHOT_VERSION;
+    image->header.n_rows       = store.n_rows;
+    image->header.strings_size = array_len(image->strings);
+    image->header.size         = sizeof(image->header) + array_len(image->strings) + array_len(image->rows);
+
+    flat_hash_table_free(Offset_Table, offsets);
+}
+
+/*
+ * Writes and frees image. Runs on the load monitor thread after it's let go
+ * of experiments_lock, so that the UI isn't held up by the disk, and reports
+ * through snapshot_status rather than the log.
+ */
+static void snapshot_write(Str path, Snapshot_Image *image) {
+    char  tmp_path[sizeof(snapshot_path) + 8];
+    int   fd;
+    FILE *f;
+
+    /* Write to a temporary file and rename so that readers never see a partial snapshot. */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+    if ((fd = mkstemp(tmp_path)) < 0 || (f = fdopen(fd, "w")) == NULL) {
+        snprintf(snapshot_status, sizeof(snapshot_status), "couldn't write snapshot '%s': %s", tmp_path, strerror(errno));
+        errno = 0;
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        goto out_free;
+    }
+
+    if (fwrite(&image->header,             1, sizeof(image->header),     f) != sizeof(image->header)
+    ||  fwrite(array_data(image->strings), 1, array_len(image->strings), f) != (size_t)array_len(image->strings)
+    ||  fwrite(array_data(image->rows),    1, array_len(image->rows),    f) != (size_t)array_len(image->rows)) {
+
+        snprintf(snapshot_status, sizeof(snapshot_status), "couldn't write snapshot '%s': %s", tmp_path, strerror(errno));
+        errno = 0;
+        fclose(f);
+        unlink(tmp_path);
+        goto out_free;
+    }
+
+    if (fclose(f) != 0) {
+        snprintf(snapshot_status, sizeof(snapshot_status), "couldn't write snapshot '%s': %s", tmp_path, strerror(errno));
+        errno = 0;
+        unlink(tmp_path);
+        goto out_free;
+    }
+
+    if (rename(tmp_path, path) != 0) {
+        snprintf(snapshot_status, sizeof(snapshot_status), "couldn't rename snapshot '%s': %s", tmp_path, strerror(errno));
+        errno = 0;
+        unlink(tmp_path);
+        goto out_free;
+    }
+
+    snprintf(snapshot_status, sizeof(snapshot_status), "wrote snapshot '%s' (%"PRIu64" bytes)", path, image->header.size);
+
+out_free:;
+    array_free(image->rows);
+    array_free(image->strings);
+}
+
+static int props_stat(Str path, u64 *mtime, u64 *size) {
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        errno = 0;
+        return 0;
+    }
+
+#ifdef __APPLE__
+    *mtime = (u64)st.st_mtimespec.tv_sec * 1000000000ULL + st.st_mtimespec.tv_nsec;
+#else
+    *mtime = (u64)st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+#endif
+    *size  = st.st_size;
+
+    return 1;
+}
+
+#define PROPS_READ_MAX (16384)
+
+/* Keys that aren't in needed are pushed as UNLOADED without parsing their values. */
+static void tokenize_props(Experiment *exp, const char *p, const char *end, Index_Table needed) {
+    const char *key_end;
+    const char *val;
+    const char *val_end;
+    Prop        prop;
+
+    while (p < end) {
+        if ((key_end = memchr(p, '\n', end - p)) == NULL) { break; }
+
+        val = key_end + 1;
+        if (val >= end) { break; }
+
+        if ((val_end = memchr(val, '\n', end - val)) == NULL) {
+            val_end = end;
+        }
+
+        prop.key = intern_n(p, key_end - p);
+        if (key_needed(needed, prop.key)) {
+            prop.val = parse_value(val, val_end - val);
+        } else {
+            prop.val.type = UNLOADED;
+        }
+        exp_push(exp, &prop);
+
+        p = val_end + 1;
+    }
+}
+
+/*
+ * Props files are alternating key and value lines. They're tokenized in
+ * place, so lines can be any length and each key and string value is copied
+ * exactly once, straight into the experiment. Large files are mapped; small
+ * ones (nearly all of them) are cheaper to read() in one go than to map.
+ */
+static void parse_props(Experiment *exp, Str path, u64 size, Index_Table needed) {
+    int      fd;
+    char     buff[PROPS_READ_MAX];
+    ssize_t  n;
+    char    *addr;
+
+    if (size == 0) { return; }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        errno = 0;
+        return;
+    }
+
+    if (size <= sizeof(buff)) {
+        if ((n = read(fd, buff, size)) > 0) {
+            tokenize_props(exp, buff, buff + n, needed);
+        }
+        close(fd);
+        return;
+    }
+
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        errno = 0;
+        return;
+    }
+
+    tokenize_props(exp, addr, addr + size, needed);
+
+    munmap(addr, size);
+}
+
+/* Returns 0 if there's no props file, i.e. path isn't a run. */
+static int parse_exp(Str path, Experiment *exp) {
+    char buff[sizeof(load_root) + 1024];
+    u64  size;
+
+    init_exp(exp);
+
+    if (snprintf(buff, sizeof(buff), "%s/props", path) >= (int)sizeof(buff)) { return 0; }
+
+    if (!props_stat(buff, &exp->mtime, &size)) { return 0; }
+
+    exp->name = arena_strdup(path + load_root_len + 1);
+
+    if (snapshot_load_exp(exp)) { return 1; }
+
+    __atomic_add_fetch(&n_reparsed, 1, __ATOMIC_RELAXED);
+
+    parse_props(exp, buff, size, load_needed);
+
+    return 1;
+}
+
+/*
+ * All of a load's filesystem work happens on the pool. Directories are
+ * enumerated with getdents64 and their subdirectories are handed out in
+ * chunks to be parsed as runs. Each task parses its chunk into its own
+ * result vector without taking any locks, then pushes the finished chunk onto
+ * load_done. The monitor is the only consumer: it moves finished chunks into
+ * the store while the rest are still being enumerated and parsed.
+ *
+ * A directory with a props file is a run. One without is enumerated in turn,
+ * down to crapport-max-depth, so sharded layouts like campaign/date/run work.
+ */
+
+#define LOAD_CHUNK_SIZE   (64)
+#define LOAD_MERGE_MS     (10)
+#define LOAD_REFRESH_MS   (200)
+#define LOAD_PREVIEW_ROWS (500)
+
+enum {
+    LOAD_PARSE,
+    LOAD_ENUMERATE,
+    LOAD_AGGREGATE,
+};
+
+typedef struct Load_Chunk {
+    int                kind;
+    int                gen;     /* load_gen of the load it belongs to. */
+    int                depth;   /* Of the names. Entries of crapport-dir are 1. */
+    array_t            names;   /* char, NUL-separated directories relative to crapport-dir */
+    u64                off;     /* LOAD_AGGREGATE: byte range of the records in the file. */
+    u64                len;
+    int                n;
+    array_t            results; /* Experiment */
+    int                idx;     /* In load_chunks. */
+    struct Load_Chunk *next;    /* In load_done. */
+} Load_Chunk;
+
+static array_t          load_chunks; /* Load_Chunk*, every live chunk of the current load */
+static pthread_mutex_t  load_chunks_lock = PTHREAD_MUTEX_INITIALIZER;
+static Load_Chunk      *load_done;   /* Parsed, but not yet in the store. */
+static int              load_max_depth;
+static u64              load_start_ms;
+static int              load_n_dirs;     /* Visited so far, for the progress line. */
+static u64              load_refresh_ms; /* Last progress redraw. UI thread only. */
+static int              load_shown_rows; /* Rows in the store at that redraw. */
+static int              load_gen;        /* Bumped to cancel the load in flight. */
+static pthread_t        load_monitor_pthread;
+static int              load_monitor_started; /* UI thread only. */
+static int              load_finished;   /* Set by the monitor, cleared by epump(). */
+
+static Load_Chunk *load_chunk_make(int kind, int gen, int depth) {
+    Load_Chunk *chunk;
+
+    chunk = malloc(sizeof(*chunk));
+
+    chunk->kind    = kind;
+    chunk->gen     = gen;
+    chunk->depth   = depth;
+    chunk->names   = array_make_with_cap(char, LOAD_CHUNK_SIZE * 16);
+    chunk->off     = 0;
+    chunk->len     = 0;
+    chunk->n       = 0;
+    chunk->results = array_make_with_cap(Experiment, 1);
+    chunk->idx     = -1;
+    chunk->next    = NULL;
+
+    return chunk;
+}
+
+static inline int load_cancelled(Load_Chunk *chunk) {
+    return chunk->gen != __atomic_load_n(&load_gen, __ATOMIC_RELAXED);
+}
+
+static void load_chunk_free(Load_Chunk *chunk) {
+    Experiment *exp;
+
+    array_traverse(chunk->results, exp) {
+        free_exp(exp);
+    }
+    array_free(chunk->results);
+    array_free(chunk->names);
+    free(chunk);
+}
+
+static void load_chunk_retire(Load_Chunk *chunk) {
+    pthread_mutex_lock(&load_chunks_lock);
+    *(Load_Chunk**)array_item(load_chunks, chunk->idx) = NULL;
+    pthread_mutex_unlock(&load_chunks_lock);
+
+    load_chunk_free(chunk);
+}
+
+static void load_chunks_free(void) {
+    Load_Chunk **it;
+
+    pthread_mutex_lock(&load_chunks_lock);
+    array_traverse(load_chunks, it) {
+        if (*it != NULL) { load_chunk_free(*it); }
+    }
+    array_free(load_chunks);
+    pthread_mutex_unlock(&load_chunks_lock);
+
+    load_done = NULL;
+}
+
+static void load_chunk_thr(void *arg);
+
+static void load_submit(Load_Chunk **chunk) {
+    if (*chunk == NULL) { return; }
+
+    pthread_mutex_lock(&load_chunks_lock);
+    (*chunk)->idx = array_len(load_chunks);
+    array_push(load_chunks, *chunk);
+    pthread_mutex_unlock(&load_chunks_lock);
+
+    tp_group_add_task(load_group, load_chunk_thr, *chunk);
+    *chunk = NULL;
+}
+
+/* gen is that of the chunk that found name, so that a cancelled load's children are cancelled too. */
+static void load_add(Load_Chunk **chunk, int kind, int gen, int depth, Str name) {
+    if (*chunk == NULL) {
+        *chunk = load_chunk_make(kind, gen, depth);
+    }
+
+    array_push_n((*chunk)->names, (char*)name, strlen(name) + 1);
+    (*chunk)->n += 1;
+
+    if ((*chunk)->n == LOAD_CHUNK_SIZE) {
+        load_submit(chunk);
+    }
+}
+
+static void load_found(int dir_fd, Str dir_name, Str name, int type, int gen, int depth, Load_Chunk **parse) {
+    struct stat st;
+    char        rel[1024];
+
+    if (name[0] == '.') { return; }
+
+    /* Not every filesystem fills in d_type. */
+    if (type == DT_UNKNOWN) {
+        if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            errno = 0;
+            return;
+        }
+        if (S_ISDIR(st.st_mode)) { type = DT_DIR; }
+    }
+
+    if (type != DT_DIR) { return; }
+
+    if (dir_name[0]) {
+        if (snprintf(rel, sizeof(rel), "%s/%s", dir_name, name) >= (int)sizeof(rel)) { return; }
+    } else {
+        snprintf(rel, sizeof(rel), "%s", name);
+    }
+
+    load_add(parse, LOAD_PARSE, gen, depth + 1, rel);
+}
+
+static void load_enumerate(Str name, int gen, int depth, Load_Chunk **parse) {
+    char             path[sizeof(load_root) + 1024];
+    int              fd;
+#ifdef __linux__
+    char             buff[32768] __attribute__((aligned(8)));
+    long             n;
+    long             off;
+    struct dirent64 *ent;
+#else
+    DIR             *dir;
+    struct dirent   *ent;
+#endif
+
+    snprintf(path, sizeof(path), "%s%s%s", load_root, name[0] ? "/" : "", name);
+
+    if ((fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0) {
+        errno = 0;
+        return;
+    }
+
+#ifdef __linux__
+    while ((n = syscall(SYS_getdents64, fd, buff, sizeof(buff))) > 0) {
+        for (off = 0; off < n; off += ent->d_reclen) {
+            ent = (struct dirent64*)(buff + off);
+            load_found(fd, name, ent->d_name, ent->d_type, gen, depth, parse);
+        }
+    }
+    if (n < 0) { errno = 0; }
+
+    close(fd);
+#else
+    if ((dir = fdopendir(fd)) == NULL) {
+        errno = 0;
+        close(fd);
+        return;
+    }
+
+    while ((ent = readdir(dir)) != NULL) {
+        load_found(fd, name, ent->d_name, ent->d_type, gen, depth, parse);
+    }
+
+    closedir(dir);
+#endif
+}
+
+#ifdef __linux__
+
+/*
+ * io_uring path
+ *
+ * Each worker keeps its own ring and does a whole parse chunk's statx,
+ * openat and read/close calls as three batched submissions instead of four
+ * syscalls per run. Files bigger than PROPS_READ_MAX still go through
+ * parse_props(). Chosen per load when crapport-io-uring is on and the kernel
+ * supports the opcodes; anything else uses the synchronous path. It's off by
+ * default: with a warm page cache it measured slower than read().
+ */
+
+typedef struct {
+    uring_t      ring;
+    char        *buffs; /* LOAD_CHUNK_SIZE slots of PROPS_READ_MAX bytes */
+    char         paths[LOAD_CHUNK_SIZE][sizeof(load_root) + 1024];
+    struct statx stx[LOAD_CHUNK_SIZE];
+    int          res[LOAD_CHUNK_SIZE];
+    int          broken;
+} Load_Uring;
+
+enum {
+    URING_UNTESTED,
+    URING_WORKS,
+    URING_UNSUPPORTED,
+};
+
+static int           load_use_uring;
+static int           load_uring_status;
+static pthread_key_t load_uring_key;
+
+static void load_uring_free(void *arg) {
+    Load_Uring *u;
+
+    u = arg;
+
+    uring_free(&u->ring);
+    free(u->buffs);
+    free(u);
+}
+
+/* Only called from the UI thread. The result is cached. */
+static int load_uring_probe(void) {
+    uring_t   ring;
+    const int ops[] = { IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+
+    if (load_uring_status == URING_UNTESTED) {
+        load_uring_status = URING_UNSUPPORTED;
+
+        if (uring_init(&ring, 4) == 0) {
+            if (uring_supports(&ring, ops, sizeof(ops) / sizeof(ops[0]))
+            &&  pthread_key_create(&load_uring_key, load_uring_free) == 0) {
+
+                load_uring_status = URING_WORKS;
+            }
+            uring_free(&ring);
+        }
+    }
+
+    return load_uring_status == URING_WORKS;
+}
+
+static Load_Uring *load_uring_get(void) {
+    Load_Uring *u;
+
+    if ((u = pthread_getspecific(load_uring_key)) != NULL) {
+        return u->broken ? NULL : u;
+    }
+
+    u = malloc(sizeof(*u));
+
+    /* A chunk's reads and closes go in together. */
+    if (uring_init(&u->ring, 2 * LOAD_CHUNK_SIZE) != 0) {
+        free(u);
+        return NULL;
+    }
+
+    u->buffs  = malloc(LOAD_CHUNK_SIZE * PROPS_READ_MAX);
+    u->broken = 0;
+
+    pthread_setspecific(load_uring_key, u);
+
+    return u;
+}
+
+/* Submits what's queued and waits for n completions. user_data < LOAD_CHUNK_SIZE goes to res. */
+static int load_uring_run(Load_Uring *u, int n) {
+    struct io_uring_cqe *cqe;
+    int                  seen;
+
+    if (n == 0) { return 1; }
+
+    if (uring_submit_and_wait(&u->ring, n) < 0) { return 0; }
+
+    for (seen = 0; seen < n;) {
+        if ((cqe = uring_peek_cqe(&u->ring)) == NULL) {
+            if (uring_submit_and_wait(&u->ring, 1) < 0) { return 0; }
+            continue;
+        }
+
+        if (cqe->user_data < LOAD_CHUNK_SIZE) {
+            u->res[cqe->user_data] = cqe->res;
+        }
+
+        uring_cqe_seen(&u->ring);
+        seen += 1;
+    }
+
+    return 1;
+}
+
+enum {
+    URING_SKIP,
+    URING_DONE,
+    URING_READ,
+};
+
+/*
+ * Returns 0 if the ring couldn't be used, in which case nothing has been
+ * consumed. If it fails part way, the rest of the chunk is read synchronously.
+ */
+static int load_chunk_uring(Load_Chunk *chunk, Load_Chunk **next) {
+    Load_Uring          *u;
+    const char          *names[LOAD_CHUNK_SIZE];
+    int                  state[LOAD_CHUNK_SIZE];
+    u64                  sizes[LOAD_CHUNK_SIZE];
+    int                  fds[LOAD_CHUNK_SIZE];
+    Experiment           exps[LOAD_CHUNK_SIZE];
+    const char          *name;
+    struct io_uring_sqe *sqe;
+    int                  i;
+    int                  n;
+    int                  n_close;
+    int                  ok;
+
+    if ((u = load_uring_get()) == NULL) { return 0; }
+
+    name = array_data(chunk->names);
+    for (i = 0; i < chunk->n; i += 1) {
+        names[i] = name;
+        snprintf(u->paths[i], sizeof(u->paths[i]), "%s/%s/props", load_root, name);
+        name += strlen(name) + 1;
+
+        sqe            = uring_get_sqe(&u->ring);
+        sqe->opcode    = IORING_OP_STATX;
+        sqe->fd        = AT_FDCWD;
+        sqe->addr      = (u64)(uintptr_t)u->paths[i];
+        sqe->len       = STATX_MTIME | STATX_SIZE;
+        sqe->off       = (u64)(uintptr_t)&u->stx[i];
+        sqe->user_data = i;
+    }
+
+    if (!load_uring_run(u, chunk->n)) { goto out_broken; }
+
+    n = 0;
+    for (i = 0; i < chunk->n; i += 1) {
+        state[i] = URING_SKIP;
+
+        if (u->res[i] < 0) {
+            if (chunk->depth < load_max_depth) {
+                load_add(next, LOAD_ENUMERATE, chunk->gen, chunk->depth, names[i]);
+            }
+            continue;
+        }
+
+        init_exp(&exps[i]);
+        exps[i].name  = arena_strdup(names[i]);
+        exps[i].mtime = (u64)u->stx[i].stx_mtime.tv_sec * 1000000000ULL + u->stx[i].stx_mtime.tv_nsec;
+        sizes[i]      = u->stx[i].stx_size;
+        state[i]      = URING_DONE;
+
+        if (snapshot_load_exp(&exps[i])) { continue; }
+
+        __atomic_add_fetch(&n_reparsed, 1, __ATOMIC_RELAXED);
+
+        if (sizes[i] == 0) { continue; }
+
+        if (sizes[i] > PROPS_READ_MAX) {
+            parse_props(&exps[i], u->paths[i], sizes[i], load_needed);
+            continue;
+        }
+
+        sqe             = uring_get_sqe(&u->ring);
+        sqe->opcode     = IORING_OP_OPENAT;
+        sqe->fd         = AT_FDCWD;
+        sqe->addr       = (u64)(uintptr_t)u->paths[i];
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data  = i;
+
+        state[i]  = URING_READ;
+        n        += 1;
+    }
+
+    for (i = 0; i < chunk->n; i += 1) { u->res[i] = -1; }
+
+    if (!(ok = load_uring_run(u, n))) {
+        /* Whatever did open is ours to close. */
+        for (i = 0; i < chunk->n; i += 1) {
+            if (state[i] == URING_READ && u->res[i] >= 0) { close(u->res[i]); }
+        }
+        goto out_finish;
+    }
+
+    /* Reads first, then the closes once every read has finished. */
+    n = 0;
+    for (i = 0; i < chunk->n; i += 1) {
+        if (state[i] != URING_READ) { continue; }
+        if (u->res[i] < 0) {
+            state[i] = URING_DONE;
+            continue;
+        }
+
+        fds[i] = u->res[i];
+
+        sqe            = uring_get_sqe(&u->ring);
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = fds[i];
+        sqe->addr      = (u64)(uintptr_t)(u->buffs + i * PROPS_READ_MAX);
+        sqe->len       = PROPS_READ_MAX;
+        sqe->user_data = i;
+        n += 1;
+    }
+    n_close = 0;
+    for (i = 0; i < chunk->n; i += 1) {
+        if (state[i] != URING_READ) { continue; }
+
+        sqe            = uring_get_sqe(&u->ring);
+        sqe->opcode    = IORING_OP_CLOSE;
+        sqe->fd        = fds[i];
+        sqe->flags     = IOSQE_IO_DRAIN;
+        sqe->user_data = LOAD_CHUNK_SIZE + i;
+        n       += 1;
+        n_close += 1;
+    }
+
+    if (!(ok = load_uring_run(u, n))) {
+        /*
+         * The closes that reached the kernel still happen; closing those fds
+         * again could close someone else's. The ones that didn't are the last
+         * ones queued.
+         */
+        n_close = MIN(n_close, (int)u->ring.n_queued);
+        for (i = chunk->n - 1; i >= 0 && n_close > 0; i -= 1) {
+            if (state[i] != URING_READ) { continue; }
+            close(fds[i]);
+            n_close -= 1;
+        }
+    }
+
+out_finish:;
+    for (i = 0; i < chunk->n; i += 1) {
+        if (state[i] == URING_SKIP) { continue; }
+
+        if (state[i] == URING_READ) {
+            if (!ok) {
+                parse_props(&exps[i], u->paths[i], sizes[i], load_needed);
+            } else if (u->res[i] > 0) {
+                tokenize_props(&exps[i], u->buffs + i * PROPS_READ_MAX, u->buffs + i * PROPS_READ_MAX + u->res[i], load_needed);
+            }
+        }
+
+        array_push(chunk->results, exps[i]);
+    }
+
+    /* Don't trust this ring again. It's freed with the thread, once nothing can be in flight. */
+    if (!ok) { u->broken = 1; }
+
+    return 1;
+
+out_broken:;
+    u->broken = 1;
+
+    return 0;
+}
+
+#endif
+
+/*
+ * Aggregate files
+ *
+ * crapport-dir may also name a single results file with one record per run:
+ * JSON Lines (a flat object per line) or, if it ends in .csv, CSV with a
+ * header row. The file is mapped and cut at newlines into
+ * AGGREGATE_CHUNK_SIZE pieces that are parsed on the pool like parse chunks.
+ * Values are classified with parse_value(), just like props values, so a
+ * record produces the same row as the equivalent props file. Quoted CSV
+ * fields can't contain newlines. Rows are named by the record's own ID, id
+ * or key field, or by a hash of the record if it has none, so that their IDs
+ * don't move when records are added or removed before them. There's no
+ * snapshot or projection for these loads; reparsing the file is about as
+ * cheap.
+ */
+
+#define AGGREGATE_CHUNK_SIZE (1024 * 1024)
+
+enum {
+    AGGREGATE_NONE,
+    AGGREGATE_JSONL,
+    AGGREGATE_CSV,
+};
+
+static int      aggregate_format;
+static char    *aggregate_addr;
+static u64      aggregate_size;
+static array_t  aggregate_header; /* Str, CSV column keys */
+
+static void aggregate_close(void) {
+    if (aggregate_addr != NULL) {
+        munmap(aggregate_addr, aggregate_size);
+        aggregate_addr = NULL;
+    }
+
+    if (aggregate_format == AGGREGATE_CSV) {
+        array_free(aggregate_header);
+    }
+
+    aggregate_size   = 0;
+    aggregate_format = AGGREGATE_NONE;
+}
+
+static inline void aggregate_push(Experiment *exp, Str key, const char *val, int len) {
+    Prop prop;
+
+    prop.key = key;
+    prop.val = parse_value(val, len);
+    exp_push(exp, &prop);
+}
+
+static void aggregate_utf8(array_t *scratch, u32 c) {
+    char b[4];
+    int  n;
+
+    if (c < 0x80) {
+        b[0] = c;
+        n    = 1;
+    } else if (c < 0x800) {
+        b[0] = 0xc0 | (c >> 6);
+        b[1] = 0x80 | (c & 0x3f);
+        n    = 2;
+    } else if (c < 0x10000) {
+        b[0] = 0xe0 | (c >> 12);
+        b[1] = 0x80 | ((c >> 6) & 0x3f);
+        b[2] = 0x80 | (c & 0x3f);
+        n    = 3;
+    } else {
+        b[0] = 0xf0 | (c >> 18);
+        b[1] = 0x80 | ((c >> 12) & 0x3f);
+        b[2] = 0x80 | ((c >> 6) & 0x3f);
+        b[3] = 0x80 | (c & 0x3f);
+        n    = 4;
+    }
+
+    array_push_n(*scratch, b, n);
+}
+
+static int aggregate_hex4(const char *p, const char *end, u32 *out) {
+    int i;
+    int c;
+
+    if (end - p < 4) { return 0; }
+
+    *out = 0;
+    for (i = 0; i < 4; i += 1) {
+        c = p[i];
+        if      (c >= '0' && c <= '9') { c -= '0';      }
+        else if (c >= 'a' && c <= 'f') { c -= 'a' - 10; }
+        else if (c >= 'A' && c <= 'F') { c -= 'A' - 10; }
+        else                           { return 0;      }
+        *out = (*out << 4) | c;
+    }
+
+    return 1;
+}
+
+/*
+ * Parses the JSON string whose opening quote is at *p and moves *p past it.
+ * Strings without escapes are returned in place; others are unescaped into
+ * scratch. Returns 0 if the string is malformed.
+ */
+static int aggregate_json_string(const char **p, const char *end, array_t *scratch, const char **str, int *len) {
+    const char *s;
+    const char *q;
+    u32         c;
+    u32         lo;
+    char        ch;
+
+    s = *p + 1;
+    for (q = s; q < end && *q != '"' && *q != '\\'; q += 1);
+
+    if (q >= end) { return 0; }
+
+    if (*q == '"') {
+        *str = s;
+        *len = q - s;
+        *p   = q + 1;
+        return 1;
+    }
+
+    array_clear(*scratch);
+    array_push_n(*scratch, (char*)s, q - s);
+
+    while (q < end && *q != '"') {
+        if (*q != '\\') {
+            ch = *q;
+            array_push(*scratch, ch);
+            q += 1;
+            continue;
+        }
+
+        if (q + 1 >= end) { return 0; }
+
+        q += 2;
+        switch (q[-1]) {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u':
+                if (!aggregate_hex4(q, end, &c)) { return 0; }
+                q += 4;
+                if (c >= 0xd800 && c < 0xdc00
+                &&  end - q >= 6 && q[0] == '\\' && q[1] == 'u'
+                &&  aggregate_hex4(q + 2, end, &lo) && lo >= 0xdc00 && lo < 0xe000) {
+
+                    c  = 0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00);
+                    q += 6;
+                }
+                break;
+            default:
+                c = (unsigned char)q[-1];
+                break;
+        }
+
+        aggregate_utf8(scratch, c);
+    }
+
+    if (q >= end) { return 0; }
+
+    *str = array_data(*scratch);
+    *len = array_len(*scratch);
+    *p   = q + 1;
+
+    return 1;
+}
+
+static inline const char *aggregate_skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) { p += 1; }
+    return p;
+}
+
+/*
+ * Returns 0 if the line isn't a JSON object. Nested objects and arrays are
+ * kept as strings of their JSON text.
+ */
+static int aggregate_parse_jsonl(Experiment *exp, const char *p, const char *end, array_t *scratch) {
+    const char *s;
+    int         len;
+    const char *start;
+    int         depth;
+    Prop        prop;
+
+    p = aggregate_skip_ws(p, end);
+    if (p >= end || *p != '{') { return 0; }
+
+    for (p += 1;;) {
+        p = aggregate_skip_ws(p, end);
+        if (p < end && *p == '}') { break; }
+
+        if (p >= end || *p != '"')                              { return 0; }
+        if (!aggregate_json_string(&p, end, scratch, &s, &len)) { return 0; }
+        prop.key = intern_n(s, len);
+
+        p = aggregate_skip_ws(p, end);
+        if (p >= end || *p != ':') { return 0; }
+        p = aggregate_skip_ws(p + 1, end);
+        if (p >= end)              { return 0; }
+
+        if (*p == '"') {
+            if (!aggregate_json_string(&p, end, scratch, &s, &len)) { return 0; }
+            aggregate_push(exp, prop.key, s, len);
+        } else if (*p == '{' || *p == '[') {
+            start = p;
+            depth = 0;
+            do {
+                if (*p == '"') {
+                    if (!aggregate_json_string(&p, end, scratch, &s, &len)) { return 0; }
+                    continue;
+                }
+                if      (*p == '{' || *p == '[') { depth += 1; }
+                else if (*p == '}' || *p == ']') { depth -= 1; }
+                p += 1;
+            } while (p < end && depth > 0);
+
+            if (depth > 0) { return 0; }
+
+            prop.val.type   = STRING;
+            prop.val.string = intern_n(start, p - start);
+            exp_push(exp, &prop);
+        } else {
+            for (s = p; p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r'; p += 1);
+
+            if (p - s == 4 && memcmp(s, "true", 4) == 0) {
+                prop.val.type    = BOOLEAN;
+                prop.val.boolean = 1;
+                exp_push(exp, &prop);
+            } else if (p - s == 5 && memcmp(s, "false", 5) == 0) {
+                prop.val.type    = BOOLEAN;
+                prop.val.boolean = 0;
+                exp_push(exp, &prop);
+            } else if (!(p - s == 4 && memcmp(s, "null", 4) == 0)) {
+                /* null is the same as a missing key. */
+                aggregate_push(exp, prop.key, s, p - s);
+            }
+        }
+
+        p = aggregate_skip_ws(p, end);
+        if (p < end && *p == ',') { p += 1; continue; }
+        if (p < end && *p == '}') { break;            }
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Parses the CSV field at *p and moves *p to the comma or line end after it.
+ * Quoted fields are unquoted into scratch. Returns 0 if a quote isn't closed.
+ */
+static int aggregate_csv_field(const char **p, const char *end, array_t *scratch, const char **str, int *len) {
+    const char *q;
+    char        ch;
+
+    if (*p >= end || **p != '"') {
+        for (q = *p; q < end && *q != ','; q += 1);
+        *str = *p;
+        *len = q - *p;
+        *p   = q;
+        return 1;
+    }
+
+    array_clear(*scratch);
+
+    for (q = *p + 1;; q += 1) {
+        if (q >= end) { return 0; }
+        if (*q == '"') {
+            if (q + 1 >= end || q[1] != '"') { break; }
+            q += 1;
+        }
+        ch = *q;
+        array_push(*scratch, ch);
+    }
+
+    *str = array_data(*scratch);
+    *len = array_len(*scratch);
+    *p   = q + 1;
+
+    return 1;
+}
+
+/* Empty fields are missing keys, as are fields past the end of the header. */
+static int aggregate_parse_csv(Experiment *exp, const char *p, const char *end, array_t *scratch) {
+    int         col;
+    const char *s;
+    int         len;
+
+    for (col = 0;; col += 1) {
+        if (!aggregate_csv_field(&p, end, scratch, &s, &len)) { return 0; }
+
+        if (len > 0 && col < array_len(aggregate_header)) {
+            aggregate_push(exp, *(Str*)array_item(aggregate_header, col), s, len);
+        }
+
+        if (p >= end || *p != ',') { break; }
+        p += 1;
+    }
+
+    return 1;
+}
+
+/*
+ * The value of the record's ID, id or key field, whichever comes first, or
+ * "#" and a hash of the whole record. Records that share a name, like
+ * identical ones, are told apart by store_set_id().
+ */
+static char *aggregate_name(Experiment *exp, const char *p, const char *end) {
+    static const char *fields[] = { "ID", "id", "key" };
+    char               buff[32];
+    unsigned           i;
+    Str                key;
+    Prop              *prop;
+    Value             *val;
+
+    for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i += 1) {
+        if ((key = intern_find(fields[i])) == NULL) { continue; }
+
+        /* Later duplicates win. */
+        val = NULL;
+        exp_traverse(exp, prop) {
+            if (prop->key == key) { val = &prop->val; }
+        }
+
+        if (val == NULL) { continue; }
+
+        if (val->type == STRING) { return (char*)val->string; }
+        if (val->type == NUMBER) {
+            snprintf(buff, sizeof(buff), "%.17g", val->number);
+            return arena_strdup(buff);
+        }
+    }
+
+    snprintf(buff, sizeof(buff), "#%016"PRIx64, str_hash_n(p, end - p));
+
+    return arena_strdup(buff);
+}
+
+static void aggregate_chunk(Load_Chunk *chunk) {
+    const char *p;
+    const char *end;
+    const char *line_end;
+    const char *trim;
+    array_t     scratch;
+    Experiment  exp;
+    int         ok;
+
+    p       = aggregate_addr + chunk->off;
+    end     = p + chunk->len;
+    scratch = array_make(char);
+
+    for (; p < end && !load_cancelled(chunk); p = line_end + 1) {
+        if ((line_end = memchr(p, '\n', end - p)) == NULL) { line_end = end; }
+
+        for (trim = line_end; trim > p && (trim[-1] == '\r' || trim[-1] == ' ' || trim[-1] == '\t'); trim -= 1);
+        if (trim == p) { continue; }
+
+        init_exp(&exp);
+
+        ok = aggregate_format == AGGREGATE_CSV
+                ? aggregate_parse_csv(&exp, p, trim, &scratch)
+                : aggregate_parse_jsonl(&exp, p, trim, &scratch);
+
+        if (ok) {
+            exp.name = aggregate_name(&exp, p, trim);
+            array_push(chunk->results, exp);
+        } else {
+            free_exp(&exp);
+        }
+
+        chunk->n += 1;
+    }
+
+    array_free(scratch);
+}
+
+/*
+ * Maps path and queues its records on the pool. Call with experiments_lock
+ * held, after the pool is made.
+ */
+static int aggregate_open(Str path) {
+    int          fd;
+    struct stat  st;
+    const char  *p;
+    const char  *end;
+    const char  *line_end;
+    const char  *s;
+    int          len;
+    array_t      scratch;
+    Str          key;
+    u64          off;
+    u64          next;
+    const char  *nl;
+    Load_Chunk  *chunk;
+
+    aggregate_close();
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0 || fstat(fd, &st) != 0) {
+        yed_cerr("%s: %s", path, strerror(errno));
+        errno = 0;
+        if (fd >= 0) { close(fd); }
+        return 0;
+    }
+
+    len = strlen(path);
+    if (len >= 4 && strcmp(path + len - 4, ".csv") == 0) {
+        aggregate_format = AGGREGATE_CSV;
+        aggregate_header = array_make(Str);
+    } else {
+        aggregate_format = AGGREGATE_JSONL;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        return 1;
+    }
+
+    aggregate_size = st.st_size;
+    aggregate_addr = mmap(NULL, aggregate_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (aggregate_addr == MAP_FAILED) {
+        yed_cerr("%s: %s", path, strerror(errno));
+        errno          = 0;
+        aggregate_addr = NULL;
+        aggregate_size = 0;
+        return 0;
+    }
+
+    madvise(aggregate_addr, aggregate_size, MADV_SEQUENTIAL);
+
+    p   = aggregate_addr;
+    end = aggregate_addr + aggregate_size;
+
+    if (aggregate_format == AGGREGATE_CSV) {
+        scratch = array_make(char);
+
+        if ((line_end = memchr(p, '\n', end - p)) == NULL) { line_end = end; }
+        while (line_end > p && line_end[-1] == '\r') { line_end -= 1; }
+
+        while (p < line_end) {
+            if (!aggregate_csv_field(&p, line_end, &scratch, &s, &len)) { break; }
+            key = intern_n(s, len);
+            array_push(aggregate_header, key);
+            if (p < line_end) { p += 1; }
+        }
+
+        array_free(scratch);
+
+        p = (nl = memchr(p, '\n', end - p)) == NULL ? end : nl + 1;
+    }
+
+    for (off = p - aggregate_addr; off < aggregate_size; off = next) {
+        next = MIN(off + AGGREGATE_CHUNK_SIZE, aggregate_size);
+        if (next < aggregate_size) {
+            nl   = memchr(aggregate_addr + next, '\n', aggregate_size - next);
+            next = nl == NULL ? aggregate_size : (u64)(nl - aggregate_addr) + 1;
+        }
+
+        chunk      = load_chunk_make(LOAD_AGGREGATE, load_gen, 0);
+        chunk->off = off;
+        chunk->len = next - off;
+        load_submit(&chunk);
+    }
+
+    return 1;
+}
+
+static void load_chunk_thr(void *arg) {
+    Load_Chunk *chunk;
+    Load_Chunk *next;
+    const char *name;
+    int         i;
+    char        path[sizeof(load_root) + 1024];
+    Experiment  exp;
+
+    chunk = arg;
+    next  = NULL;
+    name  = array_data(chunk->names);
+
+    if (load_cancelled(chunk)) { goto out_discard; }
+
+    /* Not reserved up front: enumeration queues parse chunks much faster than they're parsed. */
+    if (chunk->kind == LOAD_PARSE) {
+        array_free(chunk->results);
+        chunk->results = array_make_with_cap(Experiment, chunk->n);
+    }
+
+    if (chunk->kind == LOAD_AGGREGATE) {
+        aggregate_chunk(chunk);
+        goto out_publish;
+    }
+
+    if (chunk->kind == LOAD_ENUMERATE) {
+        for (i = 0; i < chunk->n && !load_cancelled(chunk); i += 1) {
+            load_enumerate(name, chunk->gen, chunk->depth, &next);
+            name += strlen(name) + 1;
+        }
+        load_submit(&next);
+        load_chunk_retire(chunk);
+        return;
+    }
+
+#ifdef __linux__
+    if (load_use_uring && load_chunk_uring(chunk, &next)) { goto out_publish; }
+#endif
+
+    for (i = 0; i < chunk->n && !load_cancelled(chunk); i += 1) {
+        snprintf(path, sizeof(path), "%s/%s", load_root, name);
+
+        if (parse_exp(path, &exp)) {
+            array_push(chunk->results, exp);
+        } else {
+            free_exp(&exp);
+            if (chunk->depth < load_max_depth) {
+                load_add(&next, LOAD_ENUMERATE, chunk->gen, chunk->depth, name);
+            }
+        }
+
+        name += strlen(name) + 1;
+    }
+
+out_publish:;
+    /* Whatever was parsed for a cancelled load is thrown away. */
+    if (load_cancelled(chunk)) { goto out_discard; }
+
+    __atomic_add_fetch(&load_n_dirs, chunk->n, __ATOMIC_RELAXED);
+
+    load_submit(&next);
+
+    chunk->next = __atomic_load_n(&load_done, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&load_done, &chunk->next, chunk, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+
+    return;
+
+out_discard:;
+    if (next != NULL) { load_chunk_free(next); }
+    load_chunk_retire(chunk);
+}
+
+/*
+ * Moves every finished chunk into the store and returns the number of rows
+ * added. Only called from the monitor.
+ */
+static int load_merge(void) {
+    Load_Chunk *list;
+    Load_Chunk *chunk;
+    Load_Chunk *next;
+    Load_Chunk *ordered;
+    Experiment *exp;
+    Str         ID;
+    int         row;
+    int         n;
+
+    list = __atomic_exchange_n(&load_done, NULL, __ATOMIC_ACQUIRE);
+    if (list == NULL) { return 0; }
+
+    /* The list is newest first. */
+    ordered = NULL;
+    for (chunk = list; chunk != NULL; chunk = next) {
+        next        = chunk->next;
+        chunk->next = ordered;
+        ordered     = chunk;
+    }
+
+    n = 0;
+
+    pthread_mutex_lock(&experiments_lock);
+    ID = intern("ID");
+    for (chunk = ordered; chunk != NULL; chunk = chunk->next) {
+        array_traverse(chunk->results, exp) {
+            row = store_add_row(&store, exp);
+            store_set_id(&store, row, ID);
+            n += 1;
+        }
+    }
+    pthread_mutex_unlock(&experiments_lock);
+
+    for (chunk = ordered; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        load_chunk_retire(chunk);
+    }
+
+    return n;
+}
+
+/*
+ * Owns load_group for the length of a load. A newer crapport-load cancels
+ * this one by bumping load_gen and joining this thread: the tasks notice and
+ * bail, including the ones still queued, and nothing already parsed reaches
+ * the store. The new load only tears the old tables down after that.
+ */
+static void *load_monitor_thr(void *arg) {
+    int             gen;
+    int             idle;
+    int             cancelled;
+    u64             refresh_ms;
+    u64             now;
+    int             i;
+    int             write_snapshot;
+    Snapshot_Image  image;
+
+    gen            = (int)(intptr_t)arg;
+    refresh_ms     = 0;
+    write_snapshot = 0;
+
+    /* Wait for idle first so that the last merge sees every chunk. */
+    do {
+        if ((cancelled = __atomic_load_n(&load_gen, __ATOMIC_ACQUIRE) != gen)) { break; }
+
+        idle = tp_group_wait_timeout(load_group, LOAD_MERGE_MS);
+        if (load_merge() && (now = measure_time_now_ms()) - refresh_ms >= LOAD_REFRESH_MS) {
+            /* Let epump() show the new rows. */
+            refresh_ms = now;
+            yed_force_update();
+        }
+    } while (!idle);
+
+    tp_group_free(load_group);
+
+    pthread_mutex_lock(&experiments_lock);
+
+    load_group = NULL;
+
+    load_chunks_free();
+
+    if (cancelled) {
+        DBG("load %d cancelled", gen);
+        goto out_close;
+    }
+
+    store_shrink(&store);
+
+    array_clear(experiments_working);
+    for (i = 0; i < store.n_rows; i += 1) {
+        array_push(experiments_working, i);
+    }
+
+    if (snapshot_path[0]) {
+        if (store_has_unloaded(&store)) {
+            /* It would be missing the skipped values. */
+            snprintf(snapshot_status, sizeof(snapshot_status), "not writing a snapshot of a projected load");
+        } else if (n_reparsed > 0 || (u32)store.n_rows != snapshot_n_rows) {
+            snapshot_serialize(&image);
+            write_snapshot = 1;
+        } else {
+            snprintf(snapshot_status, sizeof(snapshot_status), "snapshot is up to date");
+        }
+    }
+out_close:;
+    snapshot_close();
+    aggregate_close();
+
+    pthread_mutex_unlock(&experiments_lock);
+
+    /* Only a newer load touches snapshot_path, and it joins this thread first. */
+    if (write_snapshot) { snapshot_write(snapshot_path, &image); }
+
+    if (!cancelled) {
+        __atomic_store_n(&load_finished, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&loading, 0, __ATOMIC_RELEASE);
+        yed_force_update();
+    }
+
+    return NULL;
+}
+
+/* Cancels the load in flight, if any, and waits until it's left the store alone. UI thread only. */
+static void load_cancel(void) {
+    __atomic_add_fetch(&load_gen, 1, __ATOMIC_RELEASE);
+
+    if (load_monitor_started) {
+        pthread_join(load_monitor_pthread, NULL);
+        load_monitor_started = 0;
+    }
+}
+
+u32 platform_get_num_hw_threads(void) {
+    u32 nprocs;
+
+    nprocs = 0;
+
+#ifdef __APPLE__
+    int    nm[2];
+    size_t len;
+
+    nm[0] = CTL_HW;
+    nm[1] = HW_AVAILCPU;
+    len   = 4;
+    sysctl(nm, 2, &nprocs, &len, NULL, 0);
+
+    if (nprocs < 1) {
+        nm[1] = HW_NCPU;
+        sysctl(nm, 2, &nprocs, &len, NULL, 0);
+    }
+#else
+    nprocs = get_nprocs();
+#endif
+
+    ASSERT(nprocs > 0, "failed to get the number of hw threads");
+
+    return nprocs;
+}
+
+/*
+ * Shared pool
+ *
+ * Loads, lazy projection loads and Jule runs all go through one work-stealing
+ * pool that lives as long as the plugin, each batch in its own tp_group.
+ * Loads are background work; anything the UI is waiting on is interactive,
+ * so it runs as soon as a worker finishes its current load chunk.
+ * crapport-threads sets its size ("auto" leaves a core for yed) and takes
+ * effect at the next crapport-load. crapport-cpus, e.g. "0-3,8", pins the
+ * workers so that crapport stays off the cores a benchmark is running on.
+ */
+static int pool_wanted_threads(void) {
+    int n;
+
+    if (!yed_get_var_as_int("crapport-threads", &n) || n < 1) {
+        n = MAX(1, (int)platform_get_num_hw_threads() - 1);
+    }
+
+    return n;
+}
+
+static void pool_pin(void) {
+#ifdef __linux__
+    Str         cpus;
+    cpu_set_t   set;
+    const char *p;
+    char       *end;
+    long        lo;
+    long        hi;
+    long        c;
+    int         err;
+
+    if (pool == NULL) { return; }
+
+    CPU_ZERO(&set);
+
+    if ((cpus = yed_get_var("crapport-cpus")) == NULL || !*cpus) {
+        /* Unpinned. */
+        for (c = 0; c < CPU_SETSIZE; c += 1) { CPU_SET(c, &set); }
+        goto out_set;
+    }
+
+    for (p = cpus; *p;) {
+        lo = strtol(p, &end, 10);
+        if (end == p || lo < 0) { goto out_bad; }
+        hi = lo;
+        p  = end;
+        if (*p == '-') {
+            p += 1;
+            hi = strtol(p, &end, 10);
+            if (end == p || hi < lo) { goto out_bad; }
+            p  = end;
+        }
+        for (c = lo; c <= hi && c < CPU_SETSIZE; c += 1) { CPU_SET(c, &set); }
+
+        while (*p == ',' || *p == ' ') { p += 1; }
+    }
+
+out_set:;
+    if ((err = tp_set_affinity(pool, &set)) != 0) {
+        LOG("crapport: couldn't pin the pool to crapport-cpus '%s': %s", cpus == NULL ? "" : cpus, strerror(err));
+    }
+    return;
+
+out_bad:;
+    LOG("crapport: crapport-cpus should look like '0-3,8', not '%s'", cpus);
+#endif
+}
+
+static tp_t *get_pool(void) {
+    if (pool == NULL) {
+        pool          = tp_make_ex(pool_wanted_threads(), TP_STEAL | TP_STATS);
+        pool_start_ms = measure_time_now_ms();
+        DBG("started a pool of %d workers", tp_n_workers(pool));
+        pool_pin();
+    }
+
+    return pool;
+}
+
+/* Lets queued and running tasks finish. Nothing may still be adding to a group. */
+static void pool_free(void) {
+    if (pool == NULL) { return; }
+
+    tp_stop(pool, TP_GRACEFUL);
+    tp_free(pool);
+    pool = NULL;
+}
+
+static void pool_stats_add_row(array_t *chars, const char *name, tp_stats_t *stats) {
+    char line[256];
+    int  len;
+
+    len = snprintf(line, sizeof(line), "%-8s %9llu %8llu %8llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.3f %10.1f\n",
+                   name,
+                   stats->n_tasks,
+                   stats->n_steals,
+                   stats->n_parks,
+                   stats->busy_ns / 1e6,
+                   stats->cpu_ns / 1e6,
+                   stats->busy_ns > stats->cpu_ns ? (stats->busy_ns - stats->cpu_ns) / 1e6 : 0.0,
+                   stats->idle_ns / 1e6,
+                   stats->lock_ns / 1e6,
+                   stats->n_tasks ? stats->wait_ns / 1e6 / stats->n_tasks : 0.0,
+                   stats->max_wait_ns / 1e6);
+
+    array_push_n(*chars, line, MIN(len, (int)sizeof(line) - 1));
+}
+
+/*
+ * Renders the pool's per-worker counters. Blocked is busy time spent off the
+ * CPU, so a load that's mostly blocked is waiting on I/O or an intern shard
+ * lock (or has more workers than cores), one that's mostly lock is fighting
+ * over the pool's queues, and one that's mostly idle doesn't have enough
+ * work for the workers it has.
+ */
+static void crapport_pool_stats(int n_args, char **args) {
+    array_t     chars;
+    char        line[256];
+    int         len;
+    tp_stats_t  stats;
+    tp_stats_t  total;
+    char        name[16];
+    int         i;
+    u64         worker_ns;
+    yed_buffer *buff;
+
+    (void)args;
+
+    if (n_args != 0) {
+        yed_cerr("expected 0 arguments, but got %d", n_args);
+        return;
+    }
+
+    chars = array_make(char);
+
+    if (pool == NULL) {
+        len = snprintf(line, sizeof(line), "The pool starts with the first crapport-load.\n");
+        array_push_n(chars, line, len);
+        goto out_show;
+    }
+
+    len = snprintf(line, sizeof(line), "%d workers, up %.1f s. Times are in ms.\n\n",
+                   tp_n_workers(pool), (measure_time_now_ms() - pool_start_ms) / 1000.0);
+    array_push_n(chars, line, len);
+
+    len = snprintf(line, sizeof(line), "%-8s %9s %8s %8s %10s %10s %10s %10s %10s %10s %10s\n",
+                   "worker", "tasks", "steals", "parks", "busy", "cpu", "blocked", "idle", "lock", "wait avg", "wait max");
+    array_push_n(chars, line, len);
+
+    memset(&total, 0, sizeof(total));
+
+    for (i = 0; i < tp_n_workers(pool); i += 1) {
+        if (!tp_get_stats(pool, i, &stats)) { continue; }
+
+        snprintf(name, sizeof(name), "%d", i);
+        pool_stats_add_row(&chars, name, &stats);
+
+        total.n_tasks     += stats.n_tasks;
+        total.n_steals    += stats.n_steals;
+        total.n_parks     += stats.n_parks;
+        total.busy_ns     += stats.busy_ns;
+        total.cpu_ns      += stats.cpu_ns;
+        total.idle_ns     += stats.idle_ns;
+        total.lock_ns     += stats.lock_ns;
+        total.wait_ns     += stats.wait_ns;
+        total.max_wait_ns  = MAX(total.max_wait_ns, stats.max_wait_ns);
+    }
+
+    pool_stats_add_row(&chars, "all", &total);
+
+    worker_ns = total.busy_ns + total.idle_ns;
+    if (worker_ns > 0) {
+        len = snprintf(line, sizeof(line), "\nbusy %.0f%% (on the CPU %.0f%%, blocked %.0f%%), idle %.0f%%, waiting for the pool lock %.1f%%\n",
+                       100.0 * total.busy_ns / worker_ns,
+                       100.0 * MIN(total.cpu_ns, total.busy_ns) / worker_ns,
+                       100.0 * (total.busy_ns > total.cpu_ns ? total.busy_ns - total.cpu_ns : 0) / worker_ns,
+                       100.0 * total.idle_ns / worker_ns,
+                       100.0 * total.lock_ns / worker_ns);
+        array_push_n(chars, line, len);
+    }
+
+out_show:;
+    array_zero_term(chars);
+
+    buff = yed_get_or_create_special_rdonly_buffer(POOL_STATS_BUFFER_NAME);
+    buff->flags &= ~BUFF_RD_ONLY;
+    yed_buff_clear_no_undo(buff);
+    yed_buff_insert_string_no_undo(buff, array_data(chars), 1, 1);
+    buff->flags |= BUFF_RD_ONLY;
+
+    array_free(chars);
+
+    YEXE("buffer", POOL_STATS_BUFFER_NAME);
+}
+
+/*
+ * Projection
+ *
+ * With crapport-projection on, a load only parses the values of keys that
+ * are known to be used: ID, crapport-columns and every string literal in the
+ * Jule file (which covers @row and @display-columns). Every other key still
+ * gets a column, marked unloaded. The first time one is asked for, just that
+ * column is read back out of every run's props file in the background. The
+ * job parses into columns of its own and they're merged into the store once
+ * it's done, so nothing but the merge needs experiments_lock.
+ */
+
+#define PROJECTION_PENDING "loading" /* Shown in place of a column's values while a job loads them. */
+
+typedef struct {
+    array_t      names;     /* char*, of each row when the job started */
+    array_t      mtimes;    /* u64, of each row when the job started */
+    array_t      cols;      /* Column, private to the job until it's merged */
+    Index_Table  keys;      /* key -> index into cols */
+    array_t      tasks;     /* Projection_Task */
+    tp_group_t  *group;
+    int          n_left;    /* Tasks that haven't finished. */
+    int          n_waiters; /* Threads blocked on the group. Only the last one out frees the job. */
+    int          cancel;
+    u64          start;
+} Projection_Job;
+
+typedef struct {
+    Projection_Job *job;
+    int             start; /* A multiple of 64, so no two tasks share a bitmap word. */
+    int             end;
+} Projection_Task;
+
+static Projection_Job *projection_job;   /* In flight, or NULL. Under experiments_lock. */
+static int             projection_ready; /* Set when a job's last task finishes, cleared by epump(). */
+
+/* Pushes the interned string literals in Jule code. Only existing strings unless insert is set. */
+static void projection_literals(Str code, array_t *keys, int insert) {
+    const char *p;
+    const char *end;
+    Str         key;
+
+    for (p = code; (p = strchr(p, '"')) != NULL; p = end + 1) {
+        for (end = p + 1; *end && *end != '"' && *end != '\n'; end += 1) {
+            if (*end == '\\' && end[1]) { end += 1; }
+        }
+        if (*end != '"') { break; }
+
+        if ((key = intern_lookup(p + 1, end - p - 1, insert)) != NULL) {
+            array_push(*keys, key);
+        }
+    }
+}
+
+static char *projection_jule_code(void) {
+    char       *name;
+    yed_buffer *buff;
+    FILE       *f;
+    long        size;
+    char       *code;
+
+    if ((name = yed_get_var("crapport-jule-file")) == NULL) { return NULL; }
+
+    if ((buff = yed_get_buffer(name)) != NULL) {
+        return yed_get_buffer_text(buff);
+    }
+
+    if ((f = fopen(name, "r")) == NULL) {
+        errno = 0;
+        return NULL;
+    }
+
+    code = NULL;
+
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) { goto out_close; }
+    rewind(f);
+
+    code       = malloc(size + 1);
+    size       = fread(code, 1, size, f);
+    code[size] = 0;
+
+out_close:;
+    fclose(f);
+    errno = 0;
+
+    return code;
+}
+
+/* Sets up load_needed for a new load. Call with experiments_lock held. */
+static void projection_init(void) {
+    Str       cols;
+    array_t   names;
+    array_t   keys;
+    char    **name_it;
+    Str       key;
+    Str      *key_it;
+    char     *code;
+
+    load_needed = NULL;
+
+    if (!yed_var_is_truthy("crapport-projection")) { return; }
+
+    load_needed = flat_hash_table_make(Index_Table);
+
+    if ((cols = yed_get_var("crapport-columns")) == NULL) {
+        cols = DEFAULT_CRAPPORT_COLUMNS;
+    }
+
+    keys  = array_make(Str);
+    names = sh_split(cols);
+    array_traverse(names, name_it) {
+        key = intern(*name_it);
+        array_push(keys, key);
+    }
+    free_string_array(names);
+
+    if ((code = projection_jule_code()) != NULL) {
+        projection_literals(code, &keys, 1);
+        free(code);
+    }
+
+    flat_hash_table_reserve(Index_Table, load_needed, array_len(keys) + 1);
+    flat_hash_table_insert(Index_Table, load_needed, intern("ID"), 1);
+    array_traverse(keys, key_it) {
+        flat_hash_table_insert(Index_Table, load_needed, *key_it, 1);
+    }
+
+    DBG("projection: parsing %d keys", (int)load_needed->len);
+
+    array_free(keys);
+}
+
+static void projection_free(void) {
+    if (load_needed != NULL) {
+        flat_hash_table_free(Index_Table, load_needed);
+        load_needed = NULL;
+    }
+}
+
+static void projection_load_thr(void *arg) {
+    Projection_Task  *task;
+    Projection_Job   *job;
+    int               r;
+    char              path[sizeof(load_root) + 1024];
+    u64               mtime;
+    u64               size;
+    Experiment        exp;
+    Prop             *prop;
+    int              *idx;
+
+    task = arg;
+    job  = task->job;
+
+    for (r = task->start; r < task->end; r += 1) {
+        if (__atomic_load_n(&job->cancel, __ATOMIC_RELAXED)) { break; }
+
+        snprintf(path, sizeof(path), "%s/%s/props", load_root, *(char**)array_item(job->names, r));
+
+        if (!props_stat(path, &mtime, &size)) { continue; }
+
+        init_exp(&exp);
+        parse_props(&exp, path, size, job->keys);
+
+        exp_traverse(&exp, prop) {
+            if (prop->val.type == UNLOADED)                                             { continue; }
+            if ((idx = flat_hash_table_get_val(Index_Table, job->keys, prop->key)) == NULL) { continue; }
+
+            column_set(array_item(job->cols, *idx), r, prop->val);
+        }
+
+        free_exp(&exp);
+    }
+
+    if (__atomic_sub_fetch(&job->n_left, 1, __ATOMIC_ACQ_REL) == 0) {
+        __atomic_store_n(&projection_ready, 1, __ATOMIC_RELEASE);
+        yed_force_update();
+    }
+}
+
+static void projection_job_free(Projection_Job *job) {
+    Column *col;
+
+    tp_group_free(job->group);
+
+    array_traverse(job->cols, col) {
+        array_free(col->values);
+        array_free(col->present);
+    }
+    array_free(job->cols);
+    flat_hash_table_free(Index_Table, job->keys);
+    array_free(job->tasks);
+    array_free(job->names);
+    array_free(job->mtimes);
+    free(job);
+}
+
+/*
+ * Starts loading the values of any unloaded columns among keys (interned) on
+ * the pool. Returns the job in flight, if there is one. That may be an older
+ * job that doesn't cover keys; finish it and call this again. Call with
+ * experiments_lock held.
+ */
+static Projection_Job *projection_load(array_t keys) {
+    Projection_Job   *job;
+    Str              *key_it;
+    Column           *col;
+    Column            new_col;
+    Column           *col_it;
+    Value             zero;
+    u64               word;
+    Projection_Task   task;
+    Projection_Task  *task_it;
+
+    if (projection_job != NULL) { return projection_job; }
+
+    /* Rows are still arriving. The monitor's update calls back in once they're all here. */
+    if (load_needed == NULL || __atomic_load_n(&loading, __ATOMIC_ACQUIRE)) { return NULL; }
+
+    job       = calloc(1, sizeof(*job));
+    job->cols = array_make(Column);
+    job->keys = flat_hash_table_make(Index_Table);
+
+    array_traverse(keys, key_it) {
+        if ((col = store_column(&store, *key_it, 0)) == NULL || !col->unloaded) { continue; }
+        if (flat_hash_table_get_val(Index_Table, job->keys, *key_it) != NULL)   { continue; }
+
+        memset(&new_col, 0, sizeof(new_col));
+        new_col.key   = col->key;
+        new_col.width = -1;
+
+        flat_hash_table_insert(Index_Table, job->keys, *key_it, array_len(job->cols));
+        array_push(job->cols, new_col);
+    }
+
+    if (array_len(job->cols) == 0) {
+        array_free(job->cols);
+        flat_hash_table_free(Index_Table, job->keys);
+        free(job);
+        return NULL;
+    }
+
+    job->start  = measure_time_now_ms();
+    job->names  = array_make_with_cap(char*, MAX(store.n_rows, 1));
+    job->mtimes = array_make_with_cap(u64, MAX(store.n_rows, 1));
+    array_copy(job->names,  store.names);
+    array_copy(job->mtimes, store.mtimes);
+
+    /* Sized up front so that column_set() never grows them from the tasks. */
+    memset(&zero, 0, sizeof(zero));
+    word = 0;
+    array_traverse(job->cols, col_it) {
+        col_it->values  = array_make_with_cap(Value, MAX(store.n_rows, 1));
+        col_it->present = array_make_with_cap(u64, MAX((store.n_rows + 63) >> 6, 1));
+        while (array_len(col_it->values)  < store.n_rows)             { array_push(col_it->values, zero);  }
+        while (array_len(col_it->present) < (store.n_rows + 63) >> 6) { array_push(col_it->present, word); }
+
+        /* Runs that watch mode parses from now on need these too. */
+        store_column(&store, col_it->key, 0)->pending = 1;
+        flat_hash_table_insert(Index_Table, load_needed, col_it->key, 1);
+    }
+
+    job->tasks = array_make(Projection_Task);
+    for (task.start = 0; task.start < store.n_rows; task.start += LOAD_CHUNK_SIZE) {
+        task.job = job;
+        task.end = MIN(task.start + LOAD_CHUNK_SIZE, store.n_rows);
+        array_push(job->tasks, task);
+    }
+
+    /* One extra count so that the job can't finish before all of its tasks are queued. */
+    job->n_left = array_len(job->tasks) + 1;
+
+    /* Someone is looking at these columns, so they don't queue behind a load. */
+    job->group = tp_group_make_ex(get_pool(), TP_INTERACTIVE);
+    array_traverse(job->tasks, task_it) {
+        if (!tp_group_add_task(job->group, projection_load_thr, task_it)) {
+            __atomic_sub_fetch(&job->n_left, 1, __ATOMIC_ACQ_REL);
+        }
+    }
+
+    if (__atomic_sub_fetch(&job->n_left, 1, __ATOMIC_ACQ_REL) == 0) {
+        __atomic_store_n(&projection_ready, 1, __ATOMIC_RELEASE);
+    }
+
+    projection_job = job;
+
+    return job;
+}
+
+/*
+ * Merges a finished job into the store and frees it. Rows that watch mode has
+ * replaced since the job started already have the new values. Returns 0 if the
+ * job isn't done or someone else is still waiting on it. Call with
+ * experiments_lock held.
+ */
+static int projection_finish(Projection_Job *job) {
+    Column *src;
+    Column *dst;
+    Value  *val;
+    int     r;
+    int     n_rows;
+
+    if (job->n_waiters > 0 || !tp_group_idle(job->group)) { return 0; }
+
+    /* A reload dropped it. */
+    if (job != projection_job) { goto out_free; }
+
+    n_rows = MIN(array_len(job->names), store.n_rows);
+
+    array_traverse(job->cols, src) {
+        dst = store_column(&store, src->key, 0);
+
+        for (r = 0; r < n_rows; r += 1) {
+            if (*(char**)array_item(store.names, r) != *(char**)array_item(job->names,  r)
+            ||  *(u64*)array_item(store.mtimes, r)  != *(u64*)array_item(job->mtimes, r)) {
+                continue;
+            }
+
+            if ((val = column_get(src, r)) != NULL) {
+                column_set(dst, r, *val);
+            } else {
+                column_unset(dst, r);
+            }
+        }
+
+        dst->unloaded = 0;
+        dst->pending  = 0;
+    }
+
+    DBG("projection: loaded %d columns in %"PRIu64" ms", array_len(job->cols), measure_time_now_ms() - job->start);
+
+    projection_job = NULL;
+
+out_free:;
+    projection_job_free(job);
+
+    return 1;
+}
+
+/* Stops the job in flight. Call with experiments_lock held, before the names or the interned strings go. */
+static void projection_cancel(void) {
+    Projection_Job *job;
+
+    if ((job = projection_job) == NULL) { return; }
+
+    projection_job = NULL;
+
+    __atomic_store_n(&job->cancel, 1, __ATOMIC_RELAXED);
+    tp_group_wait(job->group);
+
+    /* A Jule run waiting on it frees it. */
+    if (job->n_waiters == 0) {
+        projection_job_free(job);
+    }
+}
+
+#ifdef __linux__
+
+/*
+ * Watch mode
+ *
+ * A thread follows crapport-dir with inotify. New run directories and
+ * rewritten props files are parsed individually and their rows are appended
+ * to, or replaced in, the store without a full reload. Like the loader, it
+ * looks for runs down to crapport-max-depth, so grouping directories are
+ * watched for new children as well.
+ */
+
+#define WATCH_SETTLE_MS (250)
+
+static pthread_t watch_pthread;
+static int       watching;
+static int       watch_fd = -1;
+static int       watch_root_wd;
+static int       watch_stop_pipe[2];
+static char      watch_root[1024];
+static array_t   watch_names; /* char*, relative to watch_root, indexed by watch descriptor */
+static int       watch_max_depth;
+static int       watch_n_failed;
+static int       watch_dirty;
+
+static void watch_pend(array_t *pending, Str name) {
+    char **it;
+    char  *dup;
+
+    array_traverse(*pending, it) {
+        if (strcmp(*it, name) == 0) { return; }
+    }
+
+    dup = strdup(name);
+    array_push(*pending, dup);
+}
+
+static int watch_depth(Str name) {
+    int depth;
+
+    for (depth = 1; *name; name += 1) {
+        if (*name == '/') { depth += 1; }
+    }
+
+    return depth;
+}
+
+/*
+ * Watches the directory name and, unless it's a run or already at
+ * crapport-max-depth, every directory under it. With pending, each one is
+ * queued for parsing too: it was just created or moved in, so anything under
+ * it is new.
+ */
+static void watch_add_dir(Str name, array_t *pending) {
+    char           path[sizeof(watch_root) + 1024];
+    char           rel[1024];
+    int            depth;
+    u32            mask;
+    int            wd;
+    char          *null;
+    char         **slot;
+    struct stat    st;
+    DIR           *dir;
+    struct dirent *ent;
+
+    if (snprintf(path, sizeof(path), "%s/%s", watch_root, name) >= (int)sizeof(path)) { return; }
+
+    depth = watch_depth(name);
+
+    /* Only directories that might hold runs care about new children. */
+    mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR;
+    if (depth < watch_max_depth) { mask |= IN_CREATE; }
+
+    wd = inotify_add_watch(watch_fd, path, mask);
+    if (wd < 0) {
+        __atomic_add_fetch(&watch_n_failed, 1, __ATOMIC_RELAXED);
+        errno = 0;
+        return;
+    }
+
+    null = NULL;
+    while (array_len(watch_names) <= wd) {
+        array_push(watch_names, null);
+    }
+
+    slot = array_item(watch_names, wd);
+    if (*slot != NULL) { free(*slot); }
+    *slot = strdup(name);
+
+    if (pending != NULL) { watch_pend(pending, name); }
+
+    if (depth >= watch_max_depth) { return; }
+
+    /* The watch is already in place, so nothing created from here on is missed. */
+    snprintf(path, sizeof(path), "%s/%s/props", watch_root, name);
+    if (stat(path, &st) == 0) { return; }
+    errno = 0;
+
+    snprintf(path, sizeof(path), "%s/%s", watch_root, name);
+    if ((dir = opendir(path)) == NULL) {
+        errno = 0;
+        return;
+    }
+
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.'
+        ||  (ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN)) {
+
+            continue;
+        }
+        if (snprintf(rel, sizeof(rel), "%s/%s", name, ent->d_name) >= (int)sizeof(rel)) { continue; }
+
+        watch_add_dir(rel, pending);
+    }
+
+    closedir(dir);
+}
+
+/*
+ * Like parse_exp(), for a run that changed under watch mode. The name is
+ * interned, so a run that's rewritten over and over doesn't keep adding to
+ * the load arena. The snapshot can only be stale for these.
+ */
+static int watch_parse_exp(Str name, Index_Table needed, Experiment *exp) {
+    char path[sizeof(watch_root) + 1024];
+    u64  size;
+
+    init_exp(exp);
+
+    snprintf(path, sizeof(path), "%s/%s/props", watch_root, name);
+
+    if (!props_stat(path, &exp->mtime, &size)) { return 0; }
+
+    exp->name = (char*)intern(name);
+
+    parse_props(exp, path, size, needed);
+
+    return 1;
 }
 
-static void free_exp(Experiment *exp) {
-    Str    key;
-    Value *val;
+static void watch_apply(array_t *pending) {
+    array_t      parsed;
+    array_t      rows;
+    char       **name_it;
+    Experiment   exp;
+    Experiment  *new;
+    char        *name;
+    int         *lookup;
+    int          idx;
+    Str          ID;
+    Index_Table  needed;
+    Str          key;
+    int         *val;
+    int          n_needed;
+    u64          gen;
+
+    parsed = array_make(Experiment);
+    needed = NULL;
+
+    /* free_all() waits for this, so the arena and the intern table stay put while we parse. */
+    pthread_mutex_lock(&arena_watch_lock);
 
-    (void)key;
+    pthread_mutex_lock(&experiments_lock);
 
-    if (exp->props != NULL) {
-        hash_table_traverse(exp->props, key, val) {
-            if (val->type == STRING) {
-                free((char*)val->string);
-            }
+    /*
+     * The load may already have read these runs' directories, so they're kept
+     * and tried again once it's done. The settle timeout in watch_thr() keeps
+     * retrying as long as anything is pending.
+     */
+    if (__atomic_load_n(&loading, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&experiments_lock);
+        pthread_mutex_unlock(&arena_watch_lock);
+        goto out_free;
+    }
+
+    gen      = __atomic_load_n(&arena_gen, __ATOMIC_ACQUIRE);
+    n_needed = 0;
+
+    /* A projection job adds to load_needed under the lock, so parse with a copy. */
+    if (load_needed != NULL) {
+        needed = flat_hash_table_make(Index_Table);
+        flat_hash_table_reserve(Index_Table, needed, load_needed->len);
+        flat_hash_table_traverse(load_needed, key, val) {
+            flat_hash_table_insert(Index_Table, needed, key, *val);
         }
-        hash_table_free(exp->props);
-        exp->props = NULL;
+        n_needed = load_needed->len;
     }
-}
 
-static void free_all(void) {
-    Str         key;
-    Experiment *exp;
+    pthread_mutex_unlock(&experiments_lock);
 
-    (void)key;
+    array_traverse(*pending, name_it) {
+        /* Grouping directories and runs without props yet aren't rows. */
+        if (watch_parse_exp(*name_it, needed, &exp)) {
+            array_push(parsed, exp);
+        } else {
+            free_exp(&exp);
+        }
+    }
 
-    DBG("tearing down existing tables and threads");
+    pthread_mutex_unlock(&arena_watch_lock);
 
     pthread_mutex_lock(&experiments_lock);
 
-    free_exp(&working_layout);
-    free_exp(&layout);
+    /* A reload since has freed everything that was parsed. Same as above: try again after it. */
+    if (__atomic_load_n(&arena_gen, __ATOMIC_ACQUIRE) != gen
+    ||  __atomic_load_n(&loading, __ATOMIC_ACQUIRE)) {
 
-    array_traverse(experiments, exp) {
-        free_exp(exp);
+        pthread_mutex_unlock(&experiments_lock);
+        goto out_free;
     }
-    array_free(experiments);
 
-    if (tp != NULL) {
-        tp_stop(tp, TP_IMMEDIATE);
-        tp_free(tp);
+    /* A projection job started since, so these are missing its columns. Try again once things settle. */
+    if (load_needed != NULL && (int)load_needed->len != n_needed) {
+        pthread_mutex_unlock(&experiments_lock);
+        goto out_free;
     }
 
-    tp = NULL;
-    pthread_mutex_unlock(&experiments_lock);
-}
-
-static Str get_crapport_dir(void) {
-    Str dir;
-
-    if ((dir = yed_get_var("crapport-dir")) == NULL) {
-        dir = DEFAULT_CRAPPORT_DIR;
+    if (exp_index == NULL) {
+        rows = array_make_with_cap(int, MAX(store.n_rows, 1));
+        for (idx = 0; idx < store.n_rows; idx += 1) {
+            array_push(rows, idx);
+        }
+        exp_index = flat_hash_table_build_from_arrays(Name_Index, array_data(store.names), array_data(rows), store.n_rows);
+        array_free(rows);
     }
 
-    return dir;
-}
+    ID = intern("ID");
 
-#define RM_NL(_buff)                                          \
-do {                                                          \
-    int _len = strlen(_buff);                                 \
-    if ((_buff)[_len - 1] == '\n') { (_buff)[_len - 1] = 0; } \
-} while (0)
+    array_traverse(parsed, new) {
+        name = new->name;
 
-static inline int is_falsey(Str str) {
-    unsigned i;
-    const char *falsey[] = { "false", "False", "FALSE", "no",  "No",  "NO",  "off", "Off", "OFF" };
+        /* Rows keep their index, so the working set doesn't need to change. */
+        if ((lookup = flat_hash_table_get_val(Name_Index, exp_index, name)) != NULL) {
+            idx = *lookup;
+            flat_hash_table_delete(Name_Index, exp_index, name);
+            store_replace_row(&store, idx, new, ID);
+        } else {
+            idx = store_add_row(&store, new);
+            store_set_id(&store, idx, ID);
 
-    for (i = 0; i < sizeof(falsey) / sizeof(falsey[0]); i += 1) {
-        if (strcmp(str, falsey[i]) == 0) {
-            return 1;
+            array_push(experiments_working, idx);
         }
+
+        flat_hash_table_insert(Name_Index, exp_index, name, idx);
+        __atomic_add_fetch(&watch_dirty, 1, __ATOMIC_RELEASE);
     }
 
-    return 0;
-}
+    pthread_mutex_unlock(&experiments_lock);
 
-static inline int is_truthy(Str str) {
-    unsigned i;
-    const char *truthy[] = { "true",  "True",  "TRUE",  "yes", "Yes", "YES", "on",  "On",  "ON"  };
+    yed_force_update();
 
-    for (i = 0; i < sizeof(truthy) / sizeof(truthy[0]); i += 1) {
-        if (strcmp(str, truthy[i]) == 0) {
-            return 1;
-        }
-    }
+    array_traverse(*pending, name_it) { free(*name_it); }
+    array_clear(*pending);
 
-    return 0;
-}
+out_free:;
+    array_traverse(parsed, new) { free_exp(new); }
+    array_free(parsed);
 
-static inline int parse_number(Str str, double *d) {
-    const char *eos;
-    char       *end;
+    if (needed != NULL) {
+        flat_hash_table_free(Index_Table, needed);
+    }
+}
 
-    eos = str + strlen(str);
-    *d  = strtod(str, &end);
+static void *watch_thr(void *arg) {
+    DIR                  *dir;
+    struct dirent        *ent;
+    array_t               pending;
+    struct pollfd         pfds[2];
+    int                   n;
+    char                  buff[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t               len;
+    char                 *p;
+    struct inotify_event *ev;
+    char                **name;
+    char                  rel[1024];
 
-    return end == eos;
-}
+    (void)arg;
 
-static inline Value parse_value(Str str) {
-    Value val;
+    /* Existing runs need their own watches so that rewritten props are noticed. */
+    if ((dir = opendir(watch_root)) != NULL) {
+        while ((ent = readdir(dir)) != NULL) {
+            if (ent->d_name[0] == '.'
+            ||  (ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN)) {
 
-    if (is_falsey(str)) {
-        val.type    = BOOLEAN;
-        val.boolean = 0;
-        goto out;
+                continue;
+            }
+            watch_add_dir(ent->d_name, NULL);
+        }
+        closedir(dir);
     }
 
-    if (is_truthy(str)) {
-        val.type    = BOOLEAN;
-        val.boolean = 1;
-        goto out;
-    }
+    pending = array_make(char*);
 
-    if (parse_number(str, &val.number)) {
-        val.type = NUMBER;
-        goto out;
-    }
+    pfds[0].fd     = watch_fd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd     = watch_stop_pipe[0];
+    pfds[1].events = POLLIN;
 
-    val.type   = STRING;
-    val.string = strdup(str);
+    for (;;) {
+        /* Wait for the directory to settle before parsing anything. */
+        n = poll(pfds, 2, array_len(pending) ? WATCH_SETTLE_MS : -1);
 
-out:;
-    return val;
-}
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
 
-static void load_exp(Str path) {
-    Experiment  exp;
-    char        buff[1024];
-    FILE       *f;
-    char       *key;
-    Value       val;
-
-    init_exp(&exp);
-
-    snprintf(buff, sizeof(buff), "%s/props", path);
-    f = fopen(buff, "r");
-    if (f != NULL) {
-        while (fgets(buff, sizeof(buff), f)) {
-            RM_NL(buff);
-            key = strdup(buff);
-            if (fgets(buff, sizeof(buff), f)) {
-                RM_NL(buff);
-                val = parse_value(buff);
-                hash_table_insert(exp.props, key, val);
-            } else {
-                free(key);
+        if (pfds[1].revents) { break; }
+
+        if (n == 0) {
+            watch_apply(&pending);
+            continue;
+        }
+
+        if ((len = read(watch_fd, buff, sizeof(buff))) <= 0) { continue; }
+
+        for (p = buff; p < buff + len; p += sizeof(*ev) + ev->len) {
+            ev = (struct inotify_event*)p;
+
+            if (ev->wd == watch_root_wd) {
+                if ((ev->mask & IN_ISDIR) && ev->len > 0 && ev->name[0] != '.') {
+                    watch_add_dir(ev->name, &pending);
+                }
+            } else if (ev->wd >= 0 && ev->wd < array_len(watch_names)) {
+                name = array_item(watch_names, ev->wd);
+
+                if (ev->mask & IN_IGNORED) {
+                    free(*name);
+                    *name = NULL;
+                } else if (*name == NULL || ev->len == 0 || ev->name[0] == '.') {
+                    continue;
+                } else if (ev->mask & IN_ISDIR) {
+                    if (watch_depth(*name) < watch_max_depth
+                    &&  snprintf(rel, sizeof(rel), "%s/%s", *name, ev->name) < (int)sizeof(rel)) {
+
+                        watch_add_dir(rel, &pending);
+                    }
+                } else if (strcmp(ev->name, "props") == 0) {
+                    watch_pend(&pending, *name);
+                }
             }
         }
-        fclose(f);
     }
 
-    pthread_mutex_lock(&experiments_lock);
-    array_push(experiments, exp);
-    pthread_mutex_unlock(&experiments_lock);
-}
+    array_traverse(pending, name) { free(*name); }
+    array_free(pending);
 
-static void load_exp_thr(void *arg) {
-    load_exp(arg);
-    free(arg);
+    return NULL;
 }
 
-static void *load_monitor_thr(void *arg) {
-    Experiment *it;
-    int         i;
-    Value       v;
+static void watch_stop(void) {
+    char    c;
+    char  **name;
 
-    (void)arg;
+    if (!watching) { return; }
 
-    loading = 1;
-    tp_wait(tp);
+    c = 0;
+    if (write(watch_stop_pipe[1], &c, 1) != 1) { errno = 0; }
+    pthread_join(watch_pthread, NULL);
 
-    pthread_mutex_lock(&experiments_lock);
+    close(watch_stop_pipe[0]);
+    close(watch_stop_pipe[1]);
+    close(watch_fd);
+    watch_fd = -1;
 
-    array_clear(experiments_working);
+    array_traverse(watch_names, name) {
+        if (*name != NULL) { free(*name); }
+    }
+    array_free(watch_names);
 
-    i      = 0;
-    v.type = NUMBER;
-    array_traverse(experiments, it) {
-        v.number = (double)i;
-        hash_table_insert(it->props, strdup("ID"), v);
-        i += 1;
+    watching = 0;
+}
 
-        array_push(experiments_working, *it);
+static int watch_start(Str dname) {
+    if ((watch_fd = inotify_init1(IN_CLOEXEC)) < 0) {
+        yed_cerr("inotify_init1: %s", strerror(errno));
+        errno = 0;
+        return 0;
     }
 
-    pthread_mutex_unlock(&experiments_lock);
+    watch_root_wd = inotify_add_watch(watch_fd, dname, IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+    if (watch_root_wd < 0) {
+        yed_cerr("%s: %s", dname, strerror(errno));
+        errno = 0;
+        close(watch_fd);
+        watch_fd = -1;
+        return 0;
+    }
 
-    loading = 0;
-    yed_force_update();
+    if (pipe(watch_stop_pipe) != 0) {
+        yed_cerr("pipe: %s", strerror(errno));
+        errno = 0;
+        close(watch_fd);
+        watch_fd = -1;
+        return 0;
+    }
 
-    return NULL;
+    snprintf(watch_root, sizeof(watch_root), "%s", dname);
+    watch_names     = array_make(char*);
+    watch_n_failed  = 0;
+    watch_max_depth = load_max_depth;
+    watching        = 1;
+
+    pthread_create(&watch_pthread, NULL, watch_thr, NULL);
+
+    return 1;
 }
 
-u32 platform_get_num_hw_threads(void) {
-    u32 nprocs;
+#endif
 
-    nprocs = 0;
+static void crapport_load(int n_args, char **args);
 
-#ifdef __APPLE__
-    int    nm[2];
-    size_t len;
+static void crapport_watch(int n_args, char **args) {
+#ifdef __linux__
+    Str dname;
 
-    nm[0] = CTL_HW;
-    nm[1] = HW_AVAILCPU;
-    len   = 4;
-    sysctl(nm, 2, &nprocs, &len, NULL, 0);
+    (void)args;
 
-    if (nprocs < 1) {
-        nm[1] = HW_NCPU;
-        sysctl(nm, 2, &nprocs, &len, NULL, 0);
+    if (n_args != 0) {
+        yed_cerr("expected 0 arguments, but got %d", n_args);
+        return;
     }
-#else
-    nprocs = get_nprocs();
-#endif
 
-    ASSERT(nprocs > 0, "failed to get the number of hw threads");
+    if (watching) {
+        watch_stop();
+        LOG("crapport: stopped watching '%s'", watch_root);
+        return;
+    }
 
-    return nprocs;
+    dname = get_crapport_dir();
+
+    if (store.n_rows == 0 || strcmp(load_root, dname) != 0) {
+        crapport_load(0, NULL);
+    }
+
+    if (watch_start(dname)) {
+        LOG("crapport: watching '%s'", dname);
+    }
+#else
+    (void)n_args;
+    (void)args;
+
+    yed_cerr("crapport-watch requires inotify, which isn't available on this platform");
+#endif
 }
 
 static void crapport_load(int n_args, char **args) {
-    pthread_t      monitor_pthread;
-    Str            dname;
-    DIR           *dir;
-    struct dirent *ent;
-    char           path[1024];
-    yed_buffer    *buff;
+    Str          dname;
+    struct stat  st;
+    Load_Chunk  *root;
+    int          aggregate;
+    yed_buffer  *buff;
 
     (void)args;
 
@@ -423,40 +3724,92 @@ static void crapport_load(int n_args, char **args) {
 
     DBG("starting load for dir '%s'", dname);
 
-    dir = opendir(dname);
-    if (dir == NULL) {
+    if (stat(dname, &st) != 0) {
         yed_cerr("%s: %s", dname, strerror(errno));
         errno = 0;
         goto out;
     }
+    if (!S_ISDIR(st.st_mode) && !S_ISREG(st.st_mode)) {
+        yed_cerr("%s: %s", dname, strerror(ENOTDIR));
+        goto out;
+    }
+
+    aggregate = S_ISREG(st.st_mode);
+
+#ifdef __linux__
+    if (watching && strcmp(watch_root, dname) != 0) {
+        watch_stop();
+        LOG("crapport: stopped watching '%s'", watch_root);
+    }
+#endif
+
+    /* Nothing from a previous load may be in flight once its tables are freed. */
+    load_cancel();
+
+    if (pool != NULL && tp_n_workers(pool) != pool_wanted_threads()) {
+        pool_free();
+    }
+
+    /*
+     * Set this before anything is torn down so that the watch thread and
+     * epump() both keep their hands off until the monitor is done.
+     */
+    __atomic_store_n(&loading, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&load_finished, 0, __ATOMIC_RELAXED);
 
     free_all();
 
     pthread_mutex_lock(&experiments_lock);
 
     DBG("creating experiment table");
-    experiments         = array_make(Experiment);
-    experiments_working = array_make(Experiment);
-    DBG("spinning up threadpool");
-    tp          = tp_make(MAX(1, platform_get_num_hw_threads() - 1));
+    store_init(&store);
+    experiments_working = array_make(int);
+    load_group = tp_group_make(get_pool());
+
+    snprintf(load_root, sizeof(load_root), "%s", dname);
+    load_root_len      = strlen(load_root);
+    n_reparsed         = 0;
+    snapshot_path[0]   = 0;
+    snapshot_status[0] = 0;
+    if (!aggregate && yed_var_is_truthy("crapport-snapshot")) {
+        get_snapshot_path(snapshot_path, sizeof(snapshot_path));
+        snapshot_open(snapshot_path);
+    }
 
-    while ((ent = readdir(dir)) != NULL) {
-        if (ent->d_name[0] == '.'
-        ||  ent->d_type    != DT_DIR) {
+    load_start_ms   = measure_time_now_ms();
+    load_n_dirs     = 0;
+    load_shown_rows = 0;
 
-             continue;
-        }
+    if (!yed_get_var_as_int("crapport-max-depth", &load_max_depth) || load_max_depth < 1) {
+        load_max_depth = atoi(DEFAULT_MAX_DEPTH);
+    }
 
-        snprintf(path, sizeof(path), "%s/%s", dname, ent->d_name);
-        tp_add_task(tp, load_exp_thr, strdup(path));
+    if (aggregate) {
+        load_needed = NULL;
+    } else {
+        projection_init();
     }
 
-    pthread_create(&monitor_pthread, NULL, load_monitor_thr, NULL);
-    pthread_detach(monitor_pthread);
+#ifdef __linux__
+    load_use_uring = yed_var_is_truthy("crapport-io-uring") && load_uring_probe();
+    DBG("reading props files with %s", load_use_uring ? "io_uring" : "read()");
+#endif
 
-    pthread_mutex_unlock(&experiments_lock);
+    load_chunks = array_make(Load_Chunk*);
 
-    closedir(dir);
+    if (aggregate) {
+        aggregate_open(dname);
+    } else {
+        /* Enumeration happens on the pool too; this just queues crapport-dir itself. */
+        root = NULL;
+        load_add(&root, LOAD_ENUMERATE, load_gen, 0, "");
+        load_submit(&root);
+    }
+
+    pthread_create(&load_monitor_pthread, NULL, load_monitor_thr, (void*)(intptr_t)load_gen);
+    load_monitor_started = 1;
+
+    pthread_mutex_unlock(&experiments_lock);
 
     buff = yed_get_or_create_special_rdonly_buffer(BUFFER_NAME);
     buff->flags &= ~BUFF_RD_ONLY;
@@ -491,38 +3844,56 @@ static void crapport_set_columns(int n_args, char **args) {
     array_free(chars);
 }
 
-static unsigned value_width(Value *val) {
+/* exact is for IDs, which are integers too big for %g to show in full. */
+static unsigned value_width(Value *val, int exact) {
     switch (val->type) {
         case STRING:
             return strlen(val->string);
         case BOOLEAN:
             return 3; /* YES or NO */
         case NUMBER:
-            return snprintf(NULL, 0, "%g", val->number);
+            return snprintf(NULL, 0, exact ? "%.0f" : "%g", val->number);
     }
     return 0;
 }
 
+/*
+ * Returns the interned display columns. Columns that no experiment has
+ * aren't in the pool, so they're dropped here.
+ */
 static array_t get_keys(void) {
-    const char *cols;
-    array_t     keys;
+    const char  *cols;
+    array_t      names;
+    array_t      keys;
+    char       **name_it;
+    Str          key;
 
     if ((cols = yed_get_var("crapport-columns")) == NULL) {
         cols = DEFAULT_CRAPPORT_COLUMNS;
     }
 
-    keys = sh_split(cols);
+    names = sh_split(cols);
+    keys  = array_make(Str);
+
+    array_traverse(names, name_it) {
+        if ((key = intern_find(*name_it)) != NULL) {
+            array_push(keys, key);
+        }
+    }
+
+    free_string_array(names);
 
     return keys;
 }
 
-static Str sort_key;
-static int sort_type;
+static Column *sort_col;
+static int     sort_type;
 
 static int value_cmp(const Value *a, const Value *b) {
     switch (sort_type) {
         case STRING:
             if (a->type == STRING && b->type == STRING) {
+                if (a->string == b->string) { return 0; }
                 return strcmp(a->string, b->string);
             }
             if (a->type != STRING) { return  1; }
@@ -552,19 +3923,14 @@ static int value_cmp(const Value *a, const Value *b) {
 }
 
 static int experiment_cmp(const void *a, const void *b) {
-    const Experiment *ae;
-    const Experiment *be;
-    Value            *av;
-    Value            *bv;
+    Value *av;
+    Value *bv;
 
-    ae = a;
-    be = b;
-
-    av = hash_table_get_val(ae->props, sort_key);
-    bv = hash_table_get_val(be->props, sort_key);
+    av = column_get(sort_col, *(const int*)a);
+    bv = column_get(sort_col, *(const int*)b);
 
     if (av == NULL && bv == NULL) {
-        if (ae <= be) { return -1; }
+        if (a <= b) { return -1; }
         return 1;
     }
     if (av == NULL) { return  1; }
@@ -892,12 +4258,13 @@ static void ms_insertionsort(uint8_t *a, size_t n, size_t size, int (*cmp)(const
 
 static void update_buffer(void) {
     yed_buffer *buff;
-    Experiment *it;
+    int        *it;
     Str         key;
     Value      *val;
-    Value       new_val;
-    Value      *lookup;
     array_t     keys;
+    array_t     cols;
+    Column     *column;
+    Column    **col_it;
     int         row;
     int         col;
     Str        *key_it;
@@ -905,6 +4272,13 @@ static void update_buffer(void) {
     char       *lazy_bar = "";
     char        s[256];
     array_t     sorted_experiments;
+    int         preview;
+    array_t     rows;
+    int         i;
+    u64         elapsed;
+    int         n_dirs;
+    const char *unit;
+    Str         ID;
 
     buff = yed_get_or_create_special_rdonly_buffer(BUFFER_NAME);
 
@@ -912,55 +4286,61 @@ static void update_buffer(void) {
 
     yed_buff_clear_no_undo(buff);
 
-    if (loading) {
-        yed_buff_insert_string_no_undo(buff, "Loading...", 1, 1);
-        goto out_reset_rdonly;
+    pthread_mutex_lock(&experiments_lock);
+
+    row     = 1;
+    preview = __atomic_load_n(&loading, __ATOMIC_ACQUIRE);
+    ID      = intern_find("ID");
+
+    if (preview) {
+        elapsed = measure_time_now_ms() - load_start_ms;
+        n_dirs  = __atomic_load_n(&load_n_dirs, __ATOMIC_RELAXED);
+        unit    = aggregate_format == AGGREGATE_NONE ? "dirs" : "records";
+        snprintf(s, sizeof(s), "Loading... %d rows (%d %s, %d %s/s)",
+                 store.n_rows, n_dirs, unit, elapsed ? (int)(n_dirs * 1000ULL / elapsed) : 0, unit);
+        yed_buff_insert_string_no_undo(buff, s, row, 1);
+        row += 2;
+
+        /* Show the first rows to arrive, sorted, until the load is done. */
+        rows = array_make(int);
+        for (i = 0; i < store.n_rows && i < LOAD_PREVIEW_ROWS; i += 1) {
+            array_push(rows, i);
+        }
+    } else {
+        rows = experiments_working;
     }
 
-    pthread_mutex_lock(&experiments_lock);
+    keys = get_keys();
+    cols = array_make(Column*);
 
-    free_exp(&layout);
-    init_exp(&layout);
+    projection_load(keys);
 
-    array_traverse(experiments, it) {
-        hash_table_traverse(it->props, key, val) {
-            new_val.type   = NUMBER;
-            new_val.number = MAX(strlen(key), value_width(val));
+    /* Only the displayed columns need a layout, and only over the working rows. */
+    array_traverse(keys, key_it) {
+        if ((column = store_column(&store, *key_it, 0)) == NULL) { continue; }
 
-            if ((lookup = hash_table_get_val(layout.props, key)) == NULL) {
-                hash_table_insert(layout.props, strdup(key), new_val);
-            } else {
-                lookup->number = MAX(lookup->number, new_val.number);
-            }
+        if (column->pending) {
+            column->width = (int)MAX(strlen(column->key), strlen(PROJECTION_PENDING));
+            array_push(cols, column);
+            continue;
         }
-    }
 
-    free_exp(&working_layout);
-    init_exp(&working_layout);
+        column->width = -1;
+        array_traverse(rows, it) {
+            if ((val = column_get(column, *it)) == NULL) { continue; }
 
-    array_traverse(experiments_working, it) {
-        hash_table_traverse(it->props, key, val) {
-            new_val.type   = NUMBER;
-            new_val.number = MAX(strlen(key), value_width(val));
+            column->width = MAX(column->width, (int)MAX(strlen(column->key), value_width(val, column->key == ID)));
+        }
 
-            if ((lookup = hash_table_get_val(working_layout.props, key)) == NULL) {
-                hash_table_insert(working_layout.props, strdup(key), new_val);
-            } else {
-                lookup->number = MAX(lookup->number, new_val.number);
-            }
+        if (column->width >= 0) {
+            array_push(cols, column);
         }
     }
 
-    keys = get_keys();
-
-    row = 1;
     col = 2;
-    array_traverse(keys, key_it) {
-        key   = *key_it;
-        val   = hash_table_get_val(working_layout.props, *key_it);
-        if (val == NULL) { continue; }
-
-        width = (int)val->number;
+    array_traverse(cols, col_it) {
+        key   = (*col_it)->key;
+        width = (*col_it)->width;
         snprintf(s, sizeof(s), "%s%*s", lazy_bar, -width, key);
         yed_buff_insert_string_no_undo(buff, s, row, col);
         col += width + 3 * !!lazy_bar[0];
@@ -969,15 +4349,15 @@ static void update_buffer(void) {
     row += 1;
     col  = 2;
 
-    sorted_experiments = array_make(Experiment);
-    array_copy(sorted_experiments, experiments_working);
+    sorted_experiments = array_make(int);
+    array_copy(sorted_experiments, rows);
 
-    array_rtraverse(keys, key_it) {
-        sort_key  = *key_it;
+    array_rtraverse(cols, col_it) {
+        sort_col  = *col_it;
         sort_type = -1;
 
-        array_traverse(experiments_working, it) {
-            val = hash_table_get_val(it->props, sort_key);
+        array_traverse(rows, it) {
+            val = column_get(sort_col, *it);
             if (val == NULL) { continue; }
 
             if (sort_type < 0) {
@@ -997,16 +4377,13 @@ static void update_buffer(void) {
 
     array_traverse(sorted_experiments, it) {
         lazy_bar = "";
-        array_traverse(keys, key_it) {
-            key = *key_it;
-            val = hash_table_get_val(working_layout.props, key);
+        array_traverse(cols, col_it) {
+            width = (*col_it)->width;
+            val   = column_get(*col_it, *it);
 
-            if (val == NULL) { continue; }
-
-            width = (int)val->number;
-            val   = hash_table_get_val(it->props, key);
-
-            if (val == NULL) {
+            if ((*col_it)->pending) {
+                snprintf(s, sizeof(s), "%s%*s", lazy_bar, -width, PROJECTION_PENDING);
+            } else if (val == NULL) {
                 snprintf(s, sizeof(s), "%s%*s", lazy_bar, -width, "");
             } else {
                 switch (val->type) {
@@ -1017,7 +4394,11 @@ static void update_buffer(void) {
                         snprintf(s, sizeof(s), "%s%*s", lazy_bar, width, ((int)val->boolean) ? "YES" : "NO");
                         break;
                     case NUMBER:
-                        snprintf(s, sizeof(s), "%s%*g", lazy_bar, width, val->number);
+                        if ((*col_it)->key == ID) {
+                            snprintf(s, sizeof(s), "%s%*.0f", lazy_bar, width, val->number);
+                        } else {
+                            snprintf(s, sizeof(s), "%s%*g", lazy_bar, width, val->number);
+                        }
                         break;
 
                 }
@@ -1033,15 +4414,20 @@ static void update_buffer(void) {
 
     array_free(sorted_experiments);
 
-    free_string_array(keys);
+    array_free(cols);
+    array_free(keys);
+
+    if (preview) {
+        array_free(rows);
+    }
 
     pthread_mutex_unlock(&experiments_lock);
 
-out_reset_rdonly:;
     buff->flags |= BUFF_RD_ONLY;
 }
 
 #define JULE_MAX_OUTPUT_LEN (64000)
+#define JULE_TIMEOUT_MS     (2500)
 
 FILE *f;
 
@@ -1063,11 +4449,18 @@ static void jule_output_cb(const char *s, int n_bytes) {
 }
 
 static Jule_Status jule_eval_cb(Jule_Value *value) {
+    static u32  n_evals;
     const char *message;
 
     (void)value;
 
-    if (unlikely(jule_abort)) {
+    /* Checking the clock every eval would cost more than the eval. */
+    if (unlikely((++n_evals & 1023) == 0)
+    &&  measure_time_now_ms() - jule_start_time_ms > JULE_TIMEOUT_MS) {
+        __atomic_store_n(&jule_abort, 1, __ATOMIC_RELAXED);
+    }
+
+    if (unlikely(__atomic_load_n(&jule_abort, __ATOMIC_RELAXED))) {
         message = "crapport: TIMEOUT\n";
         jule_output_cb(message, strlen(message));
         return JULE_ERR_EVAL_CANCELLED;
@@ -1578,11 +4971,10 @@ out:;
 
 static void create_jule_builtins(Jule_Interp *interp) {
     Jule_Value *table;
-    Experiment *exp;
+    int         r;
     Jule_Value *row;
-    Str         key;
+    Column     *col;
     Value      *val;
-    Value      *lookup;
     Jule_Value *kv;
     Jule_Value *vv;
     Jule_Value *columns;
@@ -1590,32 +4982,27 @@ static void create_jule_builtins(Jule_Interp *interp) {
     table = jule_list_value();
 
     pthread_mutex_lock(&experiments_lock);
-    array_traverse(experiments, exp) {
+    for (r = 0; r < store.n_rows; r += 1) {
         row = jule_object_value();
 
-        if (layout.props != NULL) {
-            hash_table_traverse(layout.props, key, val) {
-                kv = jule_string_value(interp, key);
+        array_traverse(store.columns, col) {
+            if (col->unloaded) { continue; }
 
-                lookup = hash_table_get_val(exp->props, key);
+            kv = jule_string_value(interp, col->key);
 
-                if (lookup == NULL) {
-                    jule_insert(row, kv, jule_nil_value());
+            if ((val = column_get(col, r)) == NULL) {
+                jule_insert(row, kv, jule_nil_value());
+            } else {
+                if (val->type == STRING) {
+                    vv = jule_string_value(interp, val->string);
+                } else if (val->type == NUMBER) {
+                    vv = jule_number_value(val->number);
+                } else if (val->type == BOOLEAN) {
+                    vv = jule_number_value(val->boolean);
                 } else {
-                    val = lookup;
-
-                    if (val->type == STRING) {
-                        vv = jule_string_value(interp, val->string);
-                    } else if (val->type == NUMBER) {
-                        vv = jule_number_value(val->number);
-                    } else if (val->type == BOOLEAN) {
-                        vv = jule_number_value(val->boolean);
-                    } else {
-                        break;
-                    }
-                    jule_insert(row, kv, vv);
+                    break;
                 }
-
+                jule_insert(row, kv, vv);
             }
         }
 
@@ -1623,11 +5010,11 @@ static void create_jule_builtins(Jule_Interp *interp) {
     }
 
     columns = jule_list_value();
-    if (layout.props != NULL) {
-        hash_table_traverse(layout.props, key, val) {
-            kv = jule_string_value(interp, key);
-            columns->list = jule_push(columns->list, kv);
-        }
+    array_traverse(store.columns, col) {
+        if (col->unloaded) { continue; }
+
+        kv = jule_string_value(interp, col->key);
+        columns->list = jule_push(columns->list, kv);
     }
 
     pthread_mutex_unlock(&experiments_lock);
@@ -1641,39 +5028,35 @@ static void create_jule_builtins(Jule_Interp *interp) {
     jule_install_fn(interp,  jule_get_string_id(interp, "@color"),           j_color);
 }
 
-static void *jule_timeout_thread(void *arg) {
-    u64 now;
-
-    (void)arg;
+static char jule_file_buff[1024];
 
-    for (;;) {
-        if (jule_finished) { break; }
+static void jule_task(void *arg) {
+    char           *code;
+    Jule_Status     status;
+    array_t         keys;
+    Projection_Job *job;
 
-        if (pthread_mutex_trylock(&jule_lock) == 0) {
-            pthread_mutex_unlock(&jule_lock);
-            break;
-        }
+    code = arg;
 
-        usleep(100000);
+    /* Any column the script names has to be loaded before it's exported. */
+    keys = array_make(Str);
+    pthread_mutex_lock(&experiments_lock);
+    projection_literals(code, &keys, 0);
+    while ((job = projection_load(keys)) != NULL) {
+        job->n_waiters += 1;
+        pthread_mutex_unlock(&experiments_lock);
 
-        now = measure_time_now_ms();
+        tp_group_wait(job->group);
 
-        if (now - jule_start_time_ms > 2500) {
-            jule_abort = 1;
-            break;
+        pthread_mutex_lock(&experiments_lock);
+        job->n_waiters -= 1;
+        if (projection_finish(job)) {
+            /* Let epump() redraw the columns. */
+            __atomic_store_n(&projection_ready, 1, __ATOMIC_RELEASE);
         }
     }
-
-    return NULL;
-}
-
-static char jule_file_buff[1024];
-
-static void *jule_thread(void *arg) {
-    char        *code;
-    Jule_Status  status;
-
-    code = arg;
+    pthread_mutex_unlock(&experiments_lock);
+    array_free(keys);
 
     array_free(jule_output_chars);
     jule_output_chars = array_make_with_cap(char, JULE_MAX_OUTPUT_LEN);
@@ -1705,11 +5088,10 @@ static void *jule_thread(void *arg) {
 
     free(code);
 
-    jule_finished = 1;
+    /* Publishes the interpreter's state to after_jule(). */
+    __atomic_store_n(&jule_finished, 1, __ATOMIC_RELEASE);
 
     yed_force_update();
-
-    return NULL;
 }
 
 static yed_attrs get_err_attrs(void) {
@@ -1765,7 +5147,6 @@ static void draw_error_message(int do_draw) {
 
 
 static void update_jule(void) {
-    pthread_t   t;
     char       *name;
     yed_buffer *buff;
     char       *code;
@@ -1796,10 +5177,7 @@ static void update_jule(void) {
             jule_finished      = 0;
             jule_abort         = 0;
             jule_start_time_ms = measure_time_now_ms();
-            pthread_create(&t, NULL, jule_thread, code);
-            pthread_detach(t);
-            pthread_create(&t, NULL, jule_timeout_thread, code);
-            pthread_detach(t);
+            tp_add_task_ex(get_pool(), jule_task, code, TP_INTERACTIVE);
             yed_force_update();
         }
     }
@@ -1810,13 +5188,12 @@ static void update_jule(void) {
 static void tge_plots(void);
 
 static void after_jule(void) {
-    yed_buffer *b;
-    Jule_Value *table;
-    Jule_Value *ID_str;
-    Jule_Value *row;
-    Jule_Value *ID_val;
-    int         idx;
-    Experiment *exp_p;
+    yed_buffer        *b;
+    Jule_Value        *table;
+    Jule_Value        *ID_str;
+    Jule_Value        *row;
+    Jule_Value        *ID_val;
+    int               *idx;
 
     b = yed_get_or_create_special_rdonly_buffer("*crapport-jule-output");
 
@@ -1845,11 +5222,11 @@ static void after_jule(void) {
         if (ID_val == NULL)              { continue; }
         if (ID_val->type != JULE_NUMBER) { continue; }
 
-        idx = (int)ID_val->number;
-        if (idx < 0 || idx >= array_len(experiments)) { continue; }
+        if (!(ID_val->number >= 0 && ID_val->number < (double)(1ULL << 48)))                   { continue; }
+        if (ID_val->number != (double)(u64)ID_val->number)                                    { continue; }
+        if ((idx = flat_hash_table_get_val(Id_Index, store.by_id, (u64)ID_val->number)) == NULL) { continue; }
 
-        exp_p = array_item(experiments, idx);
-        array_push(experiments_working, *exp_p);
+        array_push(experiments_working, *idx);
     }
 
     jule_free_value(ID_str);
@@ -1879,6 +5256,11 @@ out_unlock:;
 
 static void epump(yed_event *event) {
     u64 now;
+    int n_rows;
+#ifdef __linux__
+    int n_dirty;
+    int n_failed;
+#endif
 
     (void)event;
 
@@ -1887,21 +5269,50 @@ static void epump(yed_event *event) {
         if (now - jule_dirty_time_ms >= 500) {
             update_jule();
         }
-    } else if (jule_finished) {
+    } else if (__atomic_load_n(&jule_finished, __ATOMIC_ACQUIRE)) {
         after_jule();
         jule_finished = 0;
     }
 
-    if (loading) {
+    if (__atomic_exchange_n(&projection_ready, 0, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&experiments_lock);
+        if (projection_job != NULL) {
+            projection_finish(projection_job);
+        }
+        pthread_mutex_unlock(&experiments_lock);
+        update_buffer();
+    }
+
+#ifdef __linux__
+    if (!__atomic_load_n(&loading, __ATOMIC_ACQUIRE)
+    &&  (n_dirty = __atomic_exchange_n(&watch_dirty, 0, __ATOMIC_ACQ_REL)) != 0) {
+
+        DBG("watch: refreshed %d run(s)", n_dirty);
+        if ((n_failed = __atomic_exchange_n(&watch_n_failed, 0, __ATOMIC_RELAXED)) != 0) {
+            DBG("watch: couldn't watch %d run directories (see fs.inotify.max_user_watches)", n_failed);
+        }
         update_buffer();
-    } else if (tp != NULL) {
-        /* Tear down the threadpool if it's done loading, but still waiting for tasks. */
-        DBG("noticed we're done loading... tearing down threadpool");
+        on_jule_update();
+    }
+#endif
+
+    if (__atomic_load_n(&loading, __ATOMIC_ACQUIRE)) {
+        /* Redraw as soon as the first rows arrive, then every LOAD_REFRESH_MS. */
+        now    = measure_time_now_ms();
+        n_rows = __atomic_load_n(&store.n_rows, __ATOMIC_RELAXED);
+        if (now - load_refresh_ms >= LOAD_REFRESH_MS
+        ||  (load_shown_rows == 0 && n_rows > 0)) {
+
+            load_refresh_ms = now;
+            load_shown_rows = n_rows;
+            update_buffer();
+        }
+    } else if (__atomic_exchange_n(&load_finished, 0, __ATOMIC_ACQUIRE)) {
         pthread_mutex_lock(&experiments_lock);
-        tp_stop(tp, TP_IMMEDIATE);
-        tp_free(tp);
-        tp = NULL;
-        DBG("%d experiments loaded", array_len(experiments));
+        DBG("%d experiments loaded (%d parsed)", store.n_rows, n_reparsed);
+        if (snapshot_status[0]) {
+            DBG("%s", snapshot_status);
+        }
         pthread_mutex_unlock(&experiments_lock);
 
         update_buffer();
@@ -2046,23 +5457,25 @@ static void erow(yed_event *event) {
 static void evar(yed_event *event) {
     if (strcmp(event->var_name, "crapport-columns") == 0) {
         update_buffer();
+    } else if (strcmp(event->var_name, "crapport-cpus") == 0) {
+        pool_pin();
     }
 }
 
 static int complete_columns(char *string, yed_completion_results *results) {
     array_t  columns;
-    Str      key;
-    Value   *val;
+    Column  *col;
     int      status;
 
     columns = array_make(char*);
 
-    if (layout.props != NULL) {
-        hash_table_traverse(layout.props, key, val) {
-            (void)val;
-            array_push(columns, key);
+    pthread_mutex_lock(&experiments_lock);
+    if (store.by_key != NULL) {
+        array_traverse(store.columns, col) {
+            array_push(columns, col->key);
         }
     }
+    pthread_mutex_unlock(&experiments_lock);
 
     FN_BODY_FOR_COMPLETE_FROM_ARRAY(string,
                                     array_len(columns),
@@ -2426,7 +5839,14 @@ static void tge_frame(TGE_Game *tge) {
 
 static void unload(yed_plugin *self) {
     (void)self;
+#ifdef __linux__
+    watch_stop();
+#endif
+    load_cancel();
+    __atomic_store_n(&jule_abort, 1, __ATOMIC_RELAXED);
+    pool_free();
     free_all();
+    array_free(arena_chunks);
     /* @todo */
 /*     yed_free_buffer(yed_get_or_create_special_rdonly_buffer(BUFFER_NAME)); */
     yed_syntax_free(&syn);
@@ -2451,10 +5871,15 @@ int yed_plugin_boot(yed_plugin *self) {
 
     Self = self;
 
+    arena_init();
+    intern_init();
+
     yed_plugin_set_unload_fn(self, unload);
 
     yed_plugin_set_command(self, "crapport-load",        crapport_load);
     yed_plugin_set_command(self, "crapport-set-columns", crapport_set_columns);
+    yed_plugin_set_command(self, "crapport-watch",       crapport_watch);
+    yed_plugin_set_command(self, "crapport-pool-stats",  crapport_pool_stats);
 
     yed_plugin_set_completion(self, "crapport-set-columns-compl-arg-0",  complete_columns);
     yed_plugin_set_completion(self, "crapport-set-columns-compl-arg-1",  complete_columns);
@@ -2547,11 +5972,27 @@ int yed_plugin_boot(yed_plugin *self) {
     if (yed_get_var("crapport-jule-live-update") == NULL) {
         yed_set_var("crapport-jule-live-update", "no");
     }
+    if (yed_get_var("crapport-snapshot") == NULL) {
+        yed_set_var("crapport-snapshot", "yes");
+    }
+    if (yed_get_var("crapport-max-depth") == NULL) {
+        yed_set_var("crapport-max-depth", DEFAULT_MAX_DEPTH);
+    }
+    if (yed_get_var("crapport-io-uring") == NULL) {
+        yed_set_var("crapport-io-uring", "no");
+    }
+    if (yed_get_var("crapport-projection") == NULL) {
+        yed_set_var("crapport-projection", "no");
+    }
+    if (yed_get_var("crapport-threads") == NULL) {
+        yed_set_var("crapport-threads", "auto");
+    }
 
     yed_set_var("crapport-debug-log", "yes");
 
     yed_get_or_create_special_rdonly_buffer(BUFFER_NAME);
     yed_get_or_create_special_rdonly_buffer("*crapport-jule-output");
+    yed_get_or_create_special_rdonly_buffer(POOL_STATS_BUFFER_NAME);
 
     return 0;
 }
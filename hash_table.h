@@ -22,6 +22,10 @@
 #define hash_table_get_val(t, k) (t->_get_val((t), (k)))
 #define hash_table_insert(t, k, v) (t->_insert((t), (k), (v)))
 #define hash_table_delete(t, k) (t->_delete((t), (k)))
+#define hash_table_reserve(t, n) (t->_reserve((t), (n)))
+#define hash_table_shrink_to_fit(t) (t->_shrink_to_fit((t)))
+#define hash_table_build_from_arrays(K_T, V_T, HASH, EQU, keys, vals, n) \
+    (CAT2(hash_table(K_T, V_T), _build_from_arrays)((HASH), (EQU), (keys), (vals), (n)))
 #define hash_table_traverse(t, key, val_ptr)                     \
     for (/* vars */                                              \
          uint64_t __i    = 0,                                    \
@@ -114,6 +118,10 @@
         (struct _hash_table(K_T, V_T) *, K_T, V_T);                                          \
     typedef int (*CAT2(hash_table(K_T, V_T), _delete_t))                                     \
         (struct _hash_table(K_T, V_T) *, K_T);                                               \
+    typedef void (*CAT2(hash_table(K_T, V_T), _reserve_t))                                   \
+        (struct _hash_table(K_T, V_T) *, uint64_t);                                          \
+    typedef void (*CAT2(hash_table(K_T, V_T), _shrink_to_fit_t))                             \
+        (struct _hash_table(K_T, V_T) *);                                                    \
     typedef uint64_t (*CAT2(hash_table(K_T, V_T), _hash_t))(K_T);                            \
     typedef int (*CAT2(hash_table(K_T, V_T), _equ_t))(K_T, K_T);                             \
                                                                                              \
@@ -127,6 +135,8 @@
         CAT2(hash_table(K_T, V_T), _get_val_t) const _get_val;                               \
         CAT2(hash_table(K_T, V_T), _insert_t)  const _insert;                                \
         CAT2(hash_table(K_T, V_T), _delete_t)  const _delete;                                \
+        CAT2(hash_table(K_T, V_T), _reserve_t) const _reserve;                               \
+        CAT2(hash_table(K_T, V_T), _shrink_to_fit_t) const _shrink_to_fit;                   \
         CAT2(hash_table(K_T, V_T), _hash_t)    const _hash;                                  \
         CAT2(hash_table(K_T, V_T), _equ_t)     const _equ;                                   \
     }                                                                                        \
@@ -162,18 +172,33 @@
         *slot_ptr = insert_slot;                                                             \
     }                                                                                        \
                                                                                              \
+    static inline uint64_t CAT2(hash_table(K_T, V_T), _load_thresh_for)(uint64_t size) {     \
+        return ((double)((size << 1ULL)) / ((double)(size * 3))) * size;                     \
+    }                                                                                        \
+                                                                                             \
     static inline void                                                                       \
         CAT2(hash_table(K_T, V_T), _update_load_thresh)(hash_table(K_T, V_T) t) {            \
                                                                                              \
-        uint64_t cur_size;                                                                   \
+        t->_load_thresh =                                                                    \
+            CAT2(hash_table(K_T, V_T), _load_thresh_for)(t->prime_sizes[t->_size_idx]);      \
+    }                                                                                        \
+                                                                                             \
+    /* Smallest size that holds n entries without a rehash. */                               \
+    static inline uint64_t CAT2(hash_table(K_T, V_T), _size_idx_for)(uint64_t n) {           \
+        uint64_t idx;                                                                        \
+                                                                                             \
+        idx = 0;                                                                             \
+        while (CAT2(hash_table(K_T, V_T), _load_thresh_for)                                  \
+                   (CAT2(hash_table(K_T, V_T), _prime_sizes)[idx]) <= n) {                   \
+            idx += 1;                                                                        \
+        }                                                                                    \
                                                                                              \
-        cur_size        = t->prime_sizes[t->_size_idx];                                      \
-        t->_load_thresh = ((double)((cur_size << 1ULL))                                      \
-                            / ((double)(cur_size * 3)))                                      \
-                            * cur_size;                                                      \
+        return idx;                                                                          \
     }                                                                                        \
                                                                                              \
-    static inline void CAT2(hash_table(K_T, V_T), _rehash)(hash_table(K_T, V_T) t) {         \
+    static inline void                                                                       \
+        CAT2(hash_table(K_T, V_T), _rehash_to)(hash_table(K_T, V_T) t, uint64_t size_idx) {  \
+                                                                                             \
         uint64_t                   old_size,                                                 \
                                    new_data_size;                                            \
         hash_table_slot(K_T, V_T) *old_data,                                                 \
@@ -183,7 +208,7 @@
                                                                                              \
         old_size      = t->prime_sizes[t->_size_idx];                                        \
         old_data      = t->_data;                                                            \
-        t->_size_idx += 1;                                                                   \
+        t->_size_idx  = size_idx;                                                            \
         new_data_size = sizeof(hash_table_slot(K_T, V_T)) * t->prime_sizes[t->_size_idx];    \
         t->_data      = malloc(new_data_size);                                               \
         memset(t->_data, 0, new_data_size);                                                  \
@@ -203,6 +228,33 @@
         CAT2(hash_table(K_T, V_T), _update_load_thresh)(t);                                  \
     }                                                                                        \
                                                                                              \
+    static inline void CAT2(hash_table(K_T, V_T), _rehash)(hash_table(K_T, V_T) t) {         \
+        CAT2(hash_table(K_T, V_T), _rehash_to)(t, t->_size_idx + 1);                         \
+    }                                                                                        \
+                                                                                             \
+    /* Grows the table so that it holds n entries in total without rehashing. */             \
+    static inline void                                                                       \
+        CAT2(hash_table(K_T, V_T), _reserve)(hash_table(K_T, V_T) t, uint64_t n) {           \
+                                                                                             \
+        uint64_t idx;                                                                        \
+                                                                                             \
+        idx = CAT2(hash_table(K_T, V_T), _size_idx_for)(n);                                  \
+        if (idx > t->_size_idx) {                                                            \
+            CAT2(hash_table(K_T, V_T), _rehash_to)(t, idx);                                  \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
+    static inline void                                                                       \
+        CAT2(hash_table(K_T, V_T), _shrink_to_fit)(hash_table(K_T, V_T) t) {                 \
+                                                                                             \
+        uint64_t idx;                                                                        \
+                                                                                             \
+        idx = CAT2(hash_table(K_T, V_T), _size_idx_for)(t->len);                             \
+        if (idx < t->_size_idx) {                                                            \
+            CAT2(hash_table(K_T, V_T), _rehash_to)(t, idx);                                  \
+        }                                                                                    \
+    }                                                                                        \
+                                                                                             \
     static inline void                                                                       \
         CAT2(hash_table(K_T, V_T), _insert)(hash_table(K_T, V_T) t, K_T key, V_T val) {      \
         uint64_t h, data_size, idx;                                                          \
@@ -338,6 +390,8 @@
                     ._get_val    = CAT2(hash_table(K_T, V_T), _get_val),                     \
                     ._insert     = CAT2(hash_table(K_T, V_T), _insert),                      \
                     ._delete     = CAT2(hash_table(K_T, V_T), _delete),                      \
+                    ._reserve    = CAT2(hash_table(K_T, V_T), _reserve),                     \
+                    ._shrink_to_fit = CAT2(hash_table(K_T, V_T), _shrink_to_fit),            \
                     ._equ        = (CAT2(hash_table(K_T, V_T), _equ_t))equ,                  \
                     ._hash       = (CAT2(hash_table(K_T, V_T), _hash_t))hash};               \
                                                                                              \
@@ -347,5 +401,351 @@
                                                                                              \
         return t;                                                                            \
     }                                                                                        \
+                                                                                             \
+    /* Sized for n up front, so it never rehashes. Later duplicate keys win. */              \
+    static inline hash_table(K_T, V_T)                                                       \
+    CAT2(hash_table(K_T, V_T), _build_from_arrays)(CAT2(hash_table(K_T, V_T), _hash_t) hash, \
+                                                   void *equ,                                \
+                                                   K_T *keys,                                \
+                                                   V_T *vals,                                \
+                                                   uint64_t n) {                             \
+        hash_table(K_T, V_T) t;                                                              \
+        uint64_t             i;                                                              \
+                                                                                             \
+        t = CAT2(hash_table(K_T, V_T), _make)(hash, equ);                                    \
+        CAT2(hash_table(K_T, V_T), _reserve)(t, n);                                          \
+                                                                                             \
+        for (i = 0; i < n; i += 1) {                                                         \
+            CAT2(hash_table(K_T, V_T), _insert)(t, keys[i], vals[i]);                        \
+        }                                                                                    \
+                                                                                             \
+        return t;                                                                            \
+    }                                                                                        \
+
+/*
+ * Flat variant
+ *
+ * Open addressing over a power-of-two array of slots, with a control byte per
+ * slot holding 7 bits of the slot's hash. Lookups compare 16 control bytes at
+ * a time (with SSE2 where it's available) and only touch the slots whose
+ * bytes match. HASH and EQU are fixed when the table is instantiated, so
+ * nothing goes through a function pointer and every operation can inline.
+ * Tables are named, since two tables with the same types can hash
+ * differently:
+ *
+ *     use_flat_hash_table(Name_Index, Str, int, str_hash, str_equ);
+ *
+ *     Name_Index t = flat_hash_table_make(Name_Index);
+ *     flat_hash_table_insert(Name_Index, t, "x", 1);
+ *
+ * Pointers from get_key/get_val are good until the next insert.
+ */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define FLAT_HASH_TABLE_GROUP   (16)
+#define FLAT_HASH_TABLE_MIN_CAP (16)
+#define FLAT_HASH_TABLE_EMPTY   (0x80)
+#define FLAT_HASH_TABLE_DELETED (0xFE)
+
+#define flat_hash_table_make(NAME)            (CAT2(NAME, _make)())
+#define flat_hash_table_len(t)                ((t)->len)
+#define flat_hash_table_free(NAME, t)         (CAT2(NAME, _free)((t)))
+#define flat_hash_table_get_key(NAME, t, k)   (CAT2(NAME, _get_key)((t), (k)))
+#define flat_hash_table_get_val(NAME, t, k)   (CAT2(NAME, _get_val)((t), (k)))
+#define flat_hash_table_insert(NAME, t, k, v) (CAT2(NAME, _insert)((t), (k), (v)))
+#define flat_hash_table_delete(NAME, t, k)    (CAT2(NAME, _delete)((t), (k)))
+#define flat_hash_table_reserve(NAME, t, n)   (CAT2(NAME, _reserve)((t), (n)))
+#define flat_hash_table_shrink_to_fit(NAME, t) (CAT2(NAME, _shrink_to_fit)((t)))
+#define flat_hash_table_build_from_arrays(NAME, keys, vals, n) \
+    (CAT2(NAME, _build_from_arrays)((keys), (vals), (n)))
+#define flat_hash_table_traverse(t, key, val_ptr)                \
+    for (/* vars */                                              \
+         uint64_t __i = 0;                                       \
+         /* conditions */                                        \
+         __i < (t)->cap;                                         \
+         /* increment */                                         \
+         __i += 1)                                               \
+        if (!((t)->_ctrl[__i] & 0x80)                  &&        \
+            (key     = (t)->_slots[__i]._key, 1)       &&        \
+            (val_ptr = &((t)->_slots[__i]._val), 1))             \
+            /* LOOP BODY HERE */                                 \
+
+/* Bit i is set iff ctrl[i] == c. */
+static inline uint32_t flat_hash_table_match(const uint8_t *ctrl, uint8_t c) {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)ctrl), _mm_set1_epi8((char)c)));
+#else
+    uint32_t match;
+    int      i;
+
+    match = 0;
+    for (i = 0; i < FLAT_HASH_TABLE_GROUP; i += 1) {
+        match |= (uint32_t)(ctrl[i] == c) << i;
+    }
+
+    return match;
+#endif
+}
+
+/* Bit i is set iff ctrl[i] is empty or deleted. */
+static inline uint32_t flat_hash_table_match_free(const uint8_t *ctrl) {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t match;
+    int      i;
+
+    match = 0;
+    for (i = 0; i < FLAT_HASH_TABLE_GROUP; i += 1) {
+        match |= (uint32_t)(ctrl[i] >> 7) << i;
+    }
+
+    return match;
+#endif
+}
+
+/* Smallest capacity that holds n entries without growing. */
+static inline uint64_t flat_hash_table_cap_for(uint64_t n) {
+    uint64_t cap;
+
+    for (cap = FLAT_HASH_TABLE_MIN_CAP; cap - cap / 8 < n; cap *= 2);
+
+    return cap;
+}
+
+/* The control byte and the start of the probe come from different bits, so both need to be good. */
+static inline uint64_t flat_hash_table_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+#define use_flat_hash_table(NAME, K_T, V_T, HASH, EQU)                                              \
+    typedef struct {                                                                                \
+        K_T _key;                                                                                   \
+        V_T _val;                                                                                   \
+    } CAT2(NAME, _slot);                                                                            \
+                                                                                                    \
+    typedef struct CAT2(_flat_, NAME) {                                                             \
+        uint8_t           *_ctrl;  /* cap + 16 control bytes. The last 16 mirror the first. */      \
+        CAT2(NAME, _slot) *_slots;                                                                  \
+        uint64_t           cap, len, _growth_left;                                                  \
+    } *NAME;                                                                                        \
+                                                                                                    \
+    static inline CAT2(NAME, _slot) *CAT2(NAME, _find)(NAME t, K_T key, uint64_t h) {               \
+        uint64_t mask, pos, step, i;                                                                \
+        uint32_t match;                                                                             \
+        uint8_t  h2;                                                                                \
+                                                                                                    \
+        mask = t->cap - 1;                                                                          \
+        pos  = (h >> 7) & mask;                                                                     \
+        step = 0;                                                                                   \
+        h2   = h & 0x7F;                                                                            \
+                                                                                                    \
+        for (;;) {                                                                                  \
+            match = flat_hash_table_match(t->_ctrl + pos, h2);                                      \
+            while (match) {                                                                         \
+                i = (pos + __builtin_ctz(match)) & mask;                                            \
+                if (EQU(t->_slots[i]._key, key)) {                                                  \
+                    return t->_slots + i;                                                           \
+                }                                                                                   \
+                match &= match - 1;                                                                 \
+            }                                                                                       \
+                                                                                                    \
+            if (flat_hash_table_match(t->_ctrl + pos, FLAT_HASH_TABLE_EMPTY)) {                     \
+                return NULL;                                                                        \
+            }                                                                                       \
+                                                                                                    \
+            step += FLAT_HASH_TABLE_GROUP;                                                          \
+            pos   = (pos + step) & mask;                                                            \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    /* First empty or deleted slot on h's probe sequence. There always is one. */                   \
+    static inline uint64_t CAT2(NAME, _find_free)(NAME t, uint64_t h) {                             \
+        uint64_t mask, pos, step;                                                                   \
+        uint32_t match;                                                                             \
+                                                                                                    \
+        mask = t->cap - 1;                                                                          \
+        pos  = (h >> 7) & mask;                                                                     \
+        step = 0;                                                                                   \
+                                                                                                    \
+        while (!(match = flat_hash_table_match_free(t->_ctrl + pos))) {                             \
+            step += FLAT_HASH_TABLE_GROUP;                                                          \
+            pos   = (pos + step) & mask;                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return (pos + __builtin_ctz(match)) & mask;                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _set_ctrl)(NAME t, uint64_t i, uint8_t c) {                       \
+        t->_ctrl[i] = c;                                                                            \
+        if (i < FLAT_HASH_TABLE_GROUP) {                                                            \
+            t->_ctrl[t->cap + i] = c;                                                               \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _alloc)(NAME t, uint64_t cap) {                                   \
+        t->cap          = cap;                                                                      \
+        t->_ctrl        = malloc(cap + FLAT_HASH_TABLE_GROUP);                                      \
+        t->_slots       = malloc(cap * sizeof(*t->_slots));                                         \
+        t->_growth_left = cap - cap / 8 - t->len;                                                   \
+        memset(t->_ctrl, FLAT_HASH_TABLE_EMPTY, cap + FLAT_HASH_TABLE_GROUP);                       \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _resize)(NAME t, uint64_t cap) {                                  \
+        uint8_t           *old_ctrl;                                                                \
+        CAT2(NAME, _slot) *old_slots;                                                               \
+        uint64_t           old_cap, i, j, h;                                                        \
+                                                                                                    \
+        old_ctrl  = t->_ctrl;                                                                       \
+        old_slots = t->_slots;                                                                      \
+        old_cap   = t->cap;                                                                         \
+                                                                                                    \
+        CAT2(NAME, _alloc)(t, cap);                                                                 \
+                                                                                                    \
+        for (i = 0; i < old_cap; i += 1) {                                                          \
+            if (old_ctrl[i] & 0x80) { continue; }                                                   \
+            h = flat_hash_table_mix(HASH(old_slots[i]._key));                                       \
+            j = CAT2(NAME, _find_free)(t, h);                                                       \
+            CAT2(NAME, _set_ctrl)(t, j, h & 0x7F);                                                  \
+            t->_slots[j] = old_slots[i];                                                            \
+        }                                                                                           \
+                                                                                                    \
+        free(old_ctrl);                                                                             \
+        free(old_slots);                                                                            \
+    }                                                                                               \
+                                                                                                    \
+    static inline NAME CAT2(NAME, _make)(void) {                                                    \
+        NAME t;                                                                                     \
+                                                                                                    \
+        t      = malloc(sizeof(*t));                                                                \
+        t->len = 0;                                                                                 \
+                                                                                                    \
+        CAT2(NAME, _alloc)(t, FLAT_HASH_TABLE_MIN_CAP);                                             \
+                                                                                                    \
+        return t;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    /* Room for n entries in total, counting tombstones as taken. */                                \
+    static inline void CAT2(NAME, _reserve)(NAME t, uint64_t n) {                                   \
+        uint64_t cap;                                                                               \
+                                                                                                    \
+        if (n > t->len + t->_growth_left) {                                                         \
+            cap = flat_hash_table_cap_for(n);                                                       \
+            CAT2(NAME, _resize)(t, cap > t->cap ? cap : t->cap);                                    \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _shrink_to_fit)(NAME t) {                                         \
+        uint64_t cap;                                                                               \
+                                                                                                    \
+        if ((cap = flat_hash_table_cap_for(t->len)) < t->cap) {                                     \
+            CAT2(NAME, _resize)(t, cap);                                                            \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _free)(NAME t) {                                                  \
+        free(t->_ctrl);                                                                             \
+        free(t->_slots);                                                                            \
+        free(t);                                                                                    \
+    }                                                                                               \
+                                                                                                    \
+    static inline K_T *CAT2(NAME, _get_key)(NAME t, K_T key) {                                      \
+        CAT2(NAME, _slot) *slot;                                                                    \
+                                                                                                    \
+        slot = CAT2(NAME, _find)(t, key, flat_hash_table_mix(HASH(key)));                           \
+                                                                                                    \
+        return slot == NULL ? NULL : &slot->_key;                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline V_T *CAT2(NAME, _get_val)(NAME t, K_T key) {                                      \
+        CAT2(NAME, _slot) *slot;                                                                    \
+                                                                                                    \
+        slot = CAT2(NAME, _find)(t, key, flat_hash_table_mix(HASH(key)));                           \
+                                                                                                    \
+        return slot == NULL ? NULL : &slot->_val;                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline void CAT2(NAME, _insert)(NAME t, K_T key, V_T val) {                              \
+        uint64_t           h, i;                                                                    \
+        CAT2(NAME, _slot) *slot;                                                                    \
+                                                                                                    \
+        h = flat_hash_table_mix(HASH(key));                                                         \
+                                                                                                    \
+        if ((slot = CAT2(NAME, _find)(t, key, h)) != NULL) {                                        \
+            slot->_val = val;                                                                       \
+            return;                                                                                 \
+        }                                                                                           \
+                                                                                                    \
+        if (t->_growth_left == 0) {                                                                 \
+            /* Mostly tombstones: clean them out rather than growing. */                            \
+            CAT2(NAME, _resize)(t, t->len < t->cap * 7 / 16 ? t->cap : 2 * t->cap);                 \
+        }                                                                                           \
+                                                                                                    \
+        i = CAT2(NAME, _find_free)(t, h);                                                           \
+        if (t->_ctrl[i] == FLAT_HASH_TABLE_EMPTY) {                                                 \
+            t->_growth_left -= 1;                                                                   \
+        }                                                                                           \
+        CAT2(NAME, _set_ctrl)(t, i, h & 0x7F);                                                      \
+                                                                                                    \
+        slot        = t->_slots + i;                                                                \
+        slot->_key  = key;                                                                          \
+        slot->_val  = val;                                                                          \
+        t->len     += 1;                                                                            \
+    }                                                                                               \
+                                                                                                    \
+    /* Sized for n up front, so it never grows. Later duplicate keys win. */                        \
+    static inline NAME CAT2(NAME, _build_from_arrays)(K_T *keys, V_T *vals, uint64_t n) {           \
+        NAME     t;                                                                                 \
+        uint64_t i;                                                                                 \
+                                                                                                    \
+        t      = malloc(sizeof(*t));                                                                \
+        t->len = 0;                                                                                 \
+                                                                                                    \
+        CAT2(NAME, _alloc)(t, flat_hash_table_cap_for(n));                                          \
+                                                                                                    \
+        for (i = 0; i < n; i += 1) {                                                                \
+            CAT2(NAME, _insert)(t, keys[i], vals[i]);                                               \
+        }                                                                                           \
+                                                                                                    \
+        return t;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int CAT2(NAME, _delete)(NAME t, K_T key) {                                        \
+        CAT2(NAME, _slot) *slot;                                                                    \
+        uint64_t           i;                                                                       \
+        uint32_t           before, after;                                                           \
+                                                                                                    \
+        if ((slot = CAT2(NAME, _find)(t, key, flat_hash_table_mix(HASH(key)))) == NULL) {           \
+            return 0;                                                                               \
+        }                                                                                           \
+                                                                                                    \
+        i = slot - t->_slots;                                                                       \
+                                                                                                    \
+        /*                                                                                          \
+         * If no full group of 16 covers i, no probe ever went past it, so it                       \
+         * can go back to empty instead of becoming a tombstone.                                    \
+         */                                                                                         \
+        before = flat_hash_table_match(t->_ctrl + ((i - FLAT_HASH_TABLE_GROUP) & (t->cap - 1)), FLAT_HASH_TABLE_EMPTY);\
+        after  = flat_hash_table_match(t->_ctrl + i, FLAT_HASH_TABLE_EMPTY);                        \
+                                                                                                    \
+        if (before && after                                                                         \
+        &&  (__builtin_clz(before) - 16) + __builtin_ctz(after) < FLAT_HASH_TABLE_GROUP) {          \
+            CAT2(NAME, _set_ctrl)(t, i, FLAT_HASH_TABLE_EMPTY);                                     \
+            t->_growth_left += 1;                                                                   \
+        } else {                                                                                    \
+            CAT2(NAME, _set_ctrl)(t, i, FLAT_HASH_TABLE_DELETED);                                   \
+        }                                                                                           \
+                                                                                                    \
+        t->len -= 1;                                                                                \
+                                                                                                    \
+        return 1;                                                                                   \
+    }
 
 #endif
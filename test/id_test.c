@@ -0,0 +1,147 @@
+/*
+ * id_test.c
+ *
+ * Row IDs: they're NUMBERs, they only depend on a row's name and not on the
+ * order rows arrive in, and an aggregate file's records keep theirs when
+ * another record is inserted in front of them.
+ *
+ * It includes crapport.c to get at the real store, and ./build.sh test links
+ * with --gc-sections so that yed isn't needed. Exits non-zero if anything
+ * fails.
+ */
+
+#include "../crapport.c"
+
+static int n_failed;
+
+#define CHECK(cond)                                                \
+do {                                                               \
+    if (!(cond)) {                                                 \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+        n_failed += 1;                                             \
+    }                                                              \
+} while (0)
+
+static void add_row(Exp_Store *s, Str name) {
+    Experiment exp;
+
+    init_exp(&exp);
+    exp.name = (char*)intern(name);
+    store_set_id(s, store_add_row(s, &exp), intern("ID"));
+}
+
+static double id_of(Exp_Store *s, Str name) {
+    Value *val;
+    int    r;
+
+    for (r = 0; r < s->n_rows; r += 1) {
+        if (strcmp(*(char**)array_item(s->names, r), name) != 0) { continue; }
+
+        val = store_get(s, r, intern("ID"));
+        return val != NULL && val->type == NUMBER ? val->number : -1;
+    }
+
+    return -1;
+}
+
+/* The ID of the record on line n of a JSON Lines file, as if loaded. */
+static double record_id(Exp_Store *s, const char *file, int n) {
+    const char *p;
+    const char *end;
+    Experiment  exp;
+    array_t     scratch;
+    Str         name;
+
+    for (p = file; n > 0; n -= 1) { p = strchr(p, '\n') + 1; }
+    end = strchr(p, '\n');
+
+    scratch = array_make(char);
+    init_exp(&exp);
+    aggregate_parse_jsonl(&exp, p, end, &scratch);
+    name = aggregate_name(&exp, p, end);
+    free_exp(&exp);
+    array_free(scratch);
+
+    return id_of(s, name);
+}
+
+static void load_records(Exp_Store *s, const char *file) {
+    const char *p;
+    const char *end;
+    Experiment  exp;
+    array_t     scratch;
+
+    scratch = array_make(char);
+    for (p = file; *p; p = end + 1) {
+        end = strchr(p, '\n');
+        init_exp(&exp);
+        aggregate_parse_jsonl(&exp, p, end, &scratch);
+        exp.name = aggregate_name(&exp, p, end);
+        store_set_id(s, store_add_row(s, &exp), intern("ID"));
+        free_exp(&exp);
+    }
+    array_free(scratch);
+}
+
+int main(void) {
+    static const char *names[] = { "a/run_1", "a/run_2", "b/run_1", "b/run_2", "c" };
+    static const char *before  = "{\"bench\": \"x\", \"t\": 1}\n"
+                                 "{\"bench\": \"y\", \"t\": 2}\n"
+                                 "{\"id\": 17, \"bench\": \"z\"}\n";
+    static const char *after   = "{\"bench\": \"w\", \"t\": 0}\n"
+                                 "{\"bench\": \"x\", \"t\": 1}\n"
+                                 "{\"bench\": \"y\", \"t\": 2}\n"
+                                 "{\"id\": 17, \"bench\": \"z\"}\n";
+    Exp_Store   fwd;
+    Exp_Store   rev;
+    Value      *val;
+    unsigned    i;
+    int         n;
+    double      id;
+
+    arena_init();
+    intern_init();
+
+    /* Same IDs whichever order the rows arrive in. */
+    store_init(&fwd);
+    store_init(&rev);
+    n = sizeof(names) / sizeof(names[0]);
+    for (i = 0; i < (unsigned)n; i += 1) {
+        add_row(&fwd, names[i]);
+        add_row(&rev, names[n - 1 - i]);
+    }
+
+    for (i = 0; i < (unsigned)n; i += 1) {
+        id = id_of(&fwd, names[i]);
+
+        CHECK(id >= 0 && id < (double)(1ULL << 48) && id == (double)(u64)id);
+        CHECK(id == id_of(&rev, names[i]));
+
+        /* by_id is keyed on the number. */
+        CHECK(*flat_hash_table_get_val(Id_Index, fwd.by_id, (u64)id) == (int)i);
+    }
+
+    val = store_get(&fwd, 0, intern("ID"));
+    CHECK(val != NULL && val->type == NUMBER);
+
+    store_free(&fwd);
+    store_free(&rev);
+
+    /* Inserting a record in front of the others doesn't move their IDs. */
+    store_init(&fwd);
+    store_init(&rev);
+    load_records(&fwd, before);
+    load_records(&rev, after);
+
+    CHECK(record_id(&fwd, before, 0) == record_id(&rev, after, 1));
+    CHECK(record_id(&fwd, before, 1) == record_id(&rev, after, 2));
+    CHECK(record_id(&fwd, before, 2) == record_id(&rev, after, 3));
+    CHECK(record_id(&fwd, before, 0) != record_id(&fwd, before, 1));
+
+    store_free(&fwd);
+    store_free(&rev);
+
+    printf("id_test: %s\n", n_failed ? "FAILED" : "ok");
+
+    return n_failed != 0;
+}
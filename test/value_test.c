@@ -0,0 +1,76 @@
+/*
+ * value_test.c
+ *
+ * parse_value() has to classify values the way the strtod() classifier it
+ * replaced did, including where that was surprising, so that filters, sorting
+ * and column widths don't change on existing data. bench/value_bench does
+ * the same comparison over fuzzed input; these are the cases it found.
+ *
+ * It includes crapport.c to get at the real parse_value(), and ./build.sh
+ * test links with --gc-sections so that yed isn't needed. Exits non-zero if
+ * anything fails.
+ */
+
+#include "../crapport.c"
+
+static int n_failed;
+
+static void expect_number(Str str, double want) {
+    Value val;
+
+    val = parse_value(str, strlen(str));
+    if (val.type != NUMBER || val.number != want) {
+        printf("FAIL '%s': expected NUMBER %.17g, got type %d\n", str, want, val.type);
+        n_failed += 1;
+    }
+}
+
+static void expect_string(Str str) {
+    Value val;
+
+    val = parse_value(str, strlen(str));
+    if (val.type != STRING || strcmp(val.string, str) != 0) {
+        printf("FAIL '%s': expected STRING, got type %d\n", str, val.type);
+        n_failed += 1;
+    }
+}
+
+static void expect_boolean(Str str, int want) {
+    Value val;
+
+    val = parse_value(str, strlen(str));
+    if (val.type != BOOLEAN || val.boolean != want) {
+        printf("FAIL '%s': expected BOOLEAN %d, got type %d\n", str, want, val.type);
+        n_failed += 1;
+    }
+}
+
+int main(void) {
+    arena_init();
+    intern_init();
+
+    /* strtod() consumes all of an empty string. */
+    expect_number("", 0.0);
+
+    /* Nothing stops numbers at 63 bytes. */
+    expect_number("0.0000000000000000000000000000000000000000000000000000000000000001", 1e-64);
+    expect_number("1234567890123456789012345678901234567890123456789012345678901234567890", 1234567890123456789012345678901234567890123456789012345678901234567890.0);
+    expect_string("1.0000000000000000000000000000000000000000000000000000000000000000x");
+
+    /* Leading space is skipped, trailing space isn't. */
+    expect_number("  1.5", 1.5);
+    expect_string("1.5 ");
+    expect_string(" ");
+
+    expect_number("1e23", 1e23);
+    expect_number("0x1p3", 8.0);
+    expect_string("2024-01-22T10:00:00");
+
+    expect_boolean("yes", 1);
+    expect_boolean("OFF", 0);
+    expect_string("oN");
+
+    printf("value_test: %s\n", n_failed ? "FAILED" : "ok");
+
+    return n_failed != 0;
+}
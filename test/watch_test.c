@@ -0,0 +1,123 @@
+/*
+ * watch_test.c
+ *
+ * Watch mode and loads racing: a run that changes while a load is in flight
+ * has to show up once the load is done, not be dropped because the load was
+ * expected to pick it up. Drives watch_apply() directly, the way watch_thr()
+ * does when its settle timeout fires.
+ *
+ * It includes crapport.c to get at the real watch code. Nothing here calls
+ * into yed except yed_force_update(), which is stubbed, and ./build.sh test
+ * links with --gc-sections so that the plugin code that does is dropped.
+ * Exits non-zero if anything fails.
+ */
+
+#include "../crapport.c"
+
+static int n_failed;
+
+void yed_force_update(void) { }
+
+#define CHECK(cond)                                                \
+do {                                                               \
+    if (!(cond)) {                                                 \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+        n_failed += 1;                                             \
+    }                                                              \
+} while (0)
+
+static void put(Str run, Str runtime) {
+    char  path[sizeof(watch_root) + 1024];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", watch_root, run);
+    mkdir(path, 0755);
+
+    snprintf(path, sizeof(path), "%s/%s/props", watch_root, run);
+    f = fopen(path, "w");
+    fprintf(f, "benchmark\nxsbench\nruntime\n%s\n", runtime);
+    fclose(f);
+}
+
+static void rm(Str run) {
+    char path[sizeof(watch_root) + 1024];
+
+    snprintf(path, sizeof(path), "%s/%s/props", watch_root, run);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", watch_root, run);
+    rmdir(path);
+}
+
+/* The runtime of run's row, or -1 if there's no such row. */
+static double runtime_of(Str run) {
+    Value *val;
+    int    r;
+
+    for (r = 0; r < store.n_rows; r += 1) {
+        if (strcmp(*(char**)array_item(store.names, r), run) != 0) { continue; }
+
+        val = store_get(&store, r, intern("runtime"));
+        return val != NULL && val->type == NUMBER ? val->number : -1;
+    }
+
+    return -1;
+}
+
+int main(void) {
+    array_t pending;
+
+    arena_init();
+    intern_init();
+
+    store_init(&store);
+    experiments_working = array_make(int);
+    load_needed         = NULL;
+
+    snprintf(watch_root, sizeof(watch_root), "/tmp/crapport-watch-test-XXXXXX");
+    if (mkdtemp(watch_root) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    pending = array_make(char*);
+
+    /* A new run while a load is in flight is kept... */
+    __atomic_store_n(&loading, 1, __ATOMIC_RELEASE);
+    put("r1", "1.5");
+    watch_pend(&pending, "r1");
+    watch_apply(&pending);
+
+    CHECK(array_len(pending) == 1);
+    CHECK(runtime_of("r1") == -1);
+
+    /* ...and applied once it's done. */
+    __atomic_store_n(&loading, 0, __ATOMIC_RELEASE);
+    watch_apply(&pending);
+
+    CHECK(array_len(pending) == 0);
+    CHECK(runtime_of("r1") == 1.5);
+
+    /* Same for a run that's rewritten after the load has read it. */
+    __atomic_store_n(&loading, 1, __ATOMIC_RELEASE);
+    put("r1", "2.5");
+    watch_pend(&pending, "r1");
+    watch_apply(&pending);
+
+    CHECK(array_len(pending) == 1);
+    CHECK(runtime_of("r1") == 1.5);
+
+    __atomic_store_n(&loading, 0, __ATOMIC_RELEASE);
+    watch_apply(&pending);
+
+    CHECK(array_len(pending) == 0);
+    CHECK(runtime_of("r1") == 2.5);
+    CHECK(store.n_rows == 1);
+
+    array_free(pending);
+    rm("r1");
+    rmdir(watch_root);
+
+    printf("watch_test: %s\n", n_failed ? "FAILED" : "ok");
+
+    return n_failed != 0;
+}
@@ -10,57 +10,239 @@
 #define TP_IMMEDIATE (2)
 #define TP_GRACEFUL  (3)
 
+/* Flags for tp_make_ex(). */
+#define TP_STEAL     (1 << 0) /* Per-worker deques with random-victim stealing. */
+#define TP_STATS     (1 << 1) /* Keep the timings in tp_stats_t. Costs a few clock reads per task. */
+
+/*
+ * Priority lanes. Workers always take an interactive task before a background
+ * one, and look again after every task, so a long run of background tasks
+ * only delays interactive work by the task that's already running.
+ */
+#define TP_BACKGROUND  (0)
+#define TP_INTERACTIVE (1)
+#define TP_N_LANES     (2)
+
 typedef void   (*tp_task_fn_t)  (void*);
 typedef void * (*tp_thread_fn_t)(void*);
 
-typedef struct tp_task {
-    tp_task_fn_t    fn;
-    void           *arg;
-    struct tp_task *prev, *next;
+typedef struct {
+    tp_task_fn_t        fn;
+    void               *arg;
+    unsigned long long  queued_ns; /* TP_STATS only. */
 } tp_task_t;
 
+/*
+ * Per-worker counters, from tp_get_stats(). The times are in nanoseconds and
+ * are zero unless the pool has TP_STATS. busy_ns - cpu_ns is time a worker
+ * spent in a task but off the CPU: blocked on I/O, a lock or a page fault,
+ * or preempted because there are more threads than cores.
+ */
+typedef struct {
+    unsigned long long n_tasks;
+    unsigned long long n_steals;    /* TP_STEAL only. Tasks taken from another worker's deque. */
+    unsigned long long n_parks;     /* Times the worker found nothing to do and slept. */
+    unsigned long long busy_ns;     /* Running tasks. */
+    unsigned long long idle_ns;     /* Between tasks, including looking for one. */
+    unsigned long long cpu_ns;      /* The worker thread's CPU time. */
+    unsigned long long lock_ns;     /* Waiting for the pool's mutex. */
+    unsigned long long wait_ns;     /* Summed over tasks: from being added to starting. */
+    unsigned long long max_wait_ns;
+} tp_stats_t;
+
+/* FIFO ring buffer of tasks. Grows by doubling and never shrinks, so it doesn't allocate once it's big enough. */
 typedef struct {
-    tp_task_t    *head, *tail;
+    tp_task_t    *tasks;
+    unsigned int  cap;  /* Zero or a power of two. */
+    unsigned int  head;
     unsigned int  len;
 } tp_queue_t;
 
+/*
+ * TP_STEAL pools give each worker a Chase-Lev deque. Background tasks added
+ * from a worker go to the bottom of its own deque and it pops them from
+ * there; idle workers steal from the top of a random victim's. Tasks added
+ * from outside the pool, and all interactive tasks, go through the shared
+ * lanes. The owner's push and pop, and steals, don't take any lock.
+ */
+typedef struct tp_deque_array {
+    long                   mask;
+    struct tp_deque_array *retired; /* Older, smaller arrays. Thieves may still be reading them. */
+    tp_task_t              slots[];
+} tp_deque_array_t;
+
 typedef struct {
+    long                top    __attribute__((aligned(64)));
+    long                bottom __attribute__((aligned(64)));
+    tp_deque_array_t   *array; /* TP_STEAL only. */
+    struct _tp         *tp;
+    unsigned int        rng;
+    /* Written only by the worker. Others read them with tp_get_stats(). */
+    tp_stats_t          stats  __attribute__((aligned(64)));
+    unsigned long long  busy_since;
+    unsigned long long  idle_since;
+    int                 depth; /* Tasks in progress. More than one while helping in tp_group_wait(). */
+} __attribute__((aligned(64))) tp_worker_t;
+
+typedef struct _tp {
     pthread_mutex_t  mutex;
     pthread_cond_t   cond;
+    pthread_cond_t   idle_cond; /* Broadcast whenever the pool goes idle. */
     pthread_t       *threads;
-    tp_queue_t       queue;
+    tp_queue_t       lanes[TP_N_LANES];
+    int              flags;
     int              stop_mode;
     int              n_started;
     int              n_running;
+    int              n_workers;
+    tp_worker_t     *workers;
+    int              n_pending;  /* TP_STEAL only. Added, but not finished. */
+    int              n_queued[TP_N_LANES]; /* TP_STEAL only. lanes[i].len, readable without the mutex. */
+    int              n_sleeping; /* TP_STEAL only. */
 } tp_t;
 
+/*
+ * A group is a batch of tasks on a pool that can be waited on without
+ * waiting for the rest of the pool. Futures are group tasks that return a
+ * value; it's stored through the result pointer before the task counts as
+ * done. Only TP_STEAL pools may wait on a group from inside one of their own
+ * tasks. Don't expect a group to finish if its pool is stopped with
+ * TP_IMMEDIATE.
+ */
+typedef struct tp_group_task {
+    struct tp_group       *group;
+    tp_task_fn_t           fn;
+    tp_thread_fn_t         future_fn;
+    void                  *arg;
+    void                 **result;
+    struct tp_group_task  *next_free;
+} tp_group_task_t;
+
+typedef struct tp_group {
+    tp_t             *tp;
+    int               prio;
+    pthread_mutex_t   mutex;
+    pthread_cond_t    done_cond;
+    int               n_pending;
+    int               n_helpers; /* Workers parked on tp->cond in tp_group_wait(). */
+    tp_group_task_t  *free_list; /* Recycled records, so that steady state doesn't allocate. */
+    tp_group_task_t **blocks;
+    int               n_blocks;
+} tp_group_t;
+
 
 tp_t * tp_make(int n_workers);
+tp_t * tp_make_ex(int n_workers, int flags);
 void   tp_free(tp_t *tp);
 void   tp_stop(tp_t *tp, int stop_mode);
-void   tp_add_task(tp_t *tp, tp_task_fn_t fn, void *arg);
+int    tp_add_task(tp_t *tp, tp_task_fn_t fn, void *arg);
+int    tp_add_task_ex(tp_t *tp, tp_task_fn_t fn, void *arg, int prio);
 void   tp_wait(tp_t *tp);
+int    tp_wait_timeout(tp_t *tp, int timeout_ms);
 int    tp_running(tp_t *tp);
 int    tp_idle(tp_t *tp);
+int    tp_n_workers(tp_t *tp);
+int    tp_get_stats(tp_t *tp, int worker, tp_stats_t *out);
+#if defined(__linux__) && defined(_GNU_SOURCE)
+int    tp_set_affinity(tp_t *tp, const cpu_set_t *cpus);
+#endif
+
+tp_group_t * tp_group_make(tp_t *tp);
+tp_group_t * tp_group_make_ex(tp_t *tp, int prio);
+void         tp_group_free(tp_group_t *group);
+int          tp_group_add_task(tp_group_t *group, tp_task_fn_t fn, void *arg);
+int          tp_group_add_future(tp_group_t *group, tp_thread_fn_t fn, void *arg, void **result);
+void         tp_group_wait(tp_group_t *group);
+int          tp_group_wait_timeout(tp_group_t *group, int timeout_ms);
+int          tp_group_idle(tp_group_t *group);
 
 #endif
 
 #ifdef THREADPOOL_IMPLEMENTATION
 
-static tp_task_t * tp_task_make(tp_task_fn_t fn, void *arg) {
-    tp_task_t *task;
+#define TP_QUEUE_INITIAL_CAP (64)
 
-    task = (tp_task_t*)malloc(sizeof(*task));
+static unsigned long long tp_now_ns(void) {
+    struct timespec ts;
 
-    task->fn   = fn;
-    task->arg  = arg;
-    task->prev = task->next = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return task;
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
-static void tp_task_free(tp_task_t *task) { free(task); }
+static unsigned long long tp_stamp(tp_t *tp) {
+    return (tp->flags & TP_STATS) ? tp_now_ns() : 0;
+}
 
+/* Worker only. Readers may load the counter at any time. */
+static void tp_stat_add(unsigned long long *counter, unsigned long long n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+/* Takes the pool's mutex on behalf of w, counting how long it had to wait. */
+static void tp_lock(tp_t *tp, tp_worker_t *w) {
+    unsigned long long start;
+
+    if (!(tp->flags & TP_STATS)) {
+        pthread_mutex_lock(&tp->mutex);
+        return;
+    }
+
+    if (pthread_mutex_trylock(&tp->mutex) == 0) { return; }
+
+    start = tp_now_ns();
+    pthread_mutex_lock(&tp->mutex);
+    tp_stat_add(&w->stats.lock_ns, tp_now_ns() - start);
+}
+
+/* Runs task on w and counts it. */
+static void tp_run(tp_t *tp, tp_worker_t *w, tp_task_t *task) {
+    tp_stats_t         *stats;
+    unsigned long long  start;
+    unsigned long long  end;
+    unsigned long long  wait;
+    unsigned long long  since;
+
+    stats = &w->stats;
+
+    tp_stat_add(&stats->n_tasks, 1);
+
+    if (!(tp->flags & TP_STATS)) {
+        task->fn(task->arg);
+        return;
+    }
+
+    start = tp_now_ns();
+    wait  = start > task->queued_ns ? start - task->queued_ns : 0;
+
+    tp_stat_add(&stats->wait_ns, wait);
+    if (wait > stats->max_wait_ns) {
+        __atomic_store_n(&stats->max_wait_ns, wait, __ATOMIC_RELAXED);
+    }
+
+    /* A task run from tp_group_wait() is part of the waiting task's busy time. */
+    if (w->depth > 0) {
+        w->depth += 1;
+        task->fn(task->arg);
+        w->depth -= 1;
+        return;
+    }
+
+    /* Clear each since stamp before adding to its total so that a reader undercounts rather than counting twice. */
+    since = w->idle_since;
+    __atomic_store_n(&w->idle_since, 0, __ATOMIC_RELAXED);
+    tp_stat_add(&stats->idle_ns, start - since);
+    __atomic_store_n(&w->busy_since, start, __ATOMIC_RELAXED);
+    w->depth = 1;
+
+    task->fn(task->arg);
+
+    end = tp_now_ns();
+    w->depth = 0;
+    __atomic_store_n(&w->busy_since, 0, __ATOMIC_RELAXED);
+    tp_stat_add(&stats->busy_ns, end - start);
+    __atomic_store_n(&w->idle_since, end, __ATOMIC_RELAXED);
+}
 
 static tp_queue_t tp_queue_make(void) {
     tp_queue_t queue;
@@ -70,102 +252,136 @@ static tp_queue_t tp_queue_make(void) {
     return queue;
 }
 
-static void tp_queue_en(tp_queue_t *queue, tp_task_fn_t fn, void *arg) {
-    tp_task_t *task;
+static void tp_queue_grow(tp_queue_t *queue) {
+    unsigned int  cap;
+    tp_task_t    *tasks;
+    unsigned int  first;
 
-    task = tp_task_make(fn, arg);
+    cap   = queue->cap ? 2 * queue->cap : TP_QUEUE_INITIAL_CAP;
+    tasks = (tp_task_t*)malloc(cap * sizeof(*tasks));
 
-    if (queue->head != NULL) {
-        task->next        = queue->head;
-        queue->head->prev = task;
-        queue->head       = task;
-    } else {
-        queue->head = queue->tail = task;
+    /* Unwrap so that head is 0 again. */
+    if (queue->len > 0) {
+        first = queue->cap - queue->head;
+        if (first > queue->len) { first = queue->len; }
+        memcpy(tasks,         queue->tasks + queue->head, first * sizeof(*tasks));
+        memcpy(tasks + first, queue->tasks,               (queue->len - first) * sizeof(*tasks));
     }
 
-    queue->len += 1;
+    free(queue->tasks);
+
+    queue->tasks = tasks;
+    queue->cap   = cap;
+    queue->head  = 0;
 }
 
-static tp_task_t * tp_queue_de(tp_queue_t *queue) {
-    tp_task_t *tail;
+static void tp_queue_en(tp_queue_t *queue, tp_task_fn_t fn, void *arg, unsigned long long queued_ns) {
+    tp_task_t *task;
 
-    if (queue->tail == NULL) {
-        return NULL;
-    }
+    if (queue->len == queue->cap) { tp_queue_grow(queue); }
 
-    tail = queue->tail;
+    task            = queue->tasks + ((queue->head + queue->len) & (queue->cap - 1));
+    task->fn        = fn;
+    task->arg       = arg;
+    task->queued_ns = queued_ns;
 
-    if (tail->prev != NULL) {
-        tail->prev->next = NULL;
-        queue->tail      = tail->prev;
-    } else {
-        queue->head = queue->tail = NULL;
+    queue->len += 1;
+}
+
+static int tp_queue_de(tp_queue_t *queue, tp_task_t *out) {
+    if (queue->len == 0) {
+        return 0;
     }
 
-    tail->prev = tail->next = NULL;
+    *out = queue->tasks[queue->head];
 
-    queue->len -= 1;
+    queue->head  = (queue->head + 1) & (queue->cap - 1);
+    queue->len  -= 1;
 
-    return tail;
+    return 1;
 }
 
-static void tp_queue_clear(tp_queue_t *queue) {
-    tp_task_t *task;
+static void tp_queue_free(tp_queue_t *queue) {
+    free(queue->tasks);
+    memset(queue, 0, sizeof(*queue));
+}
+
+/* Must be called with the mutex held. */
+static unsigned int tp_lanes_len(tp_t *tp) {
+    unsigned int len;
+    int          lane;
 
-    while ((task = tp_queue_de(queue))) {
-        tp_task_free(task);
+    len = 0;
+    for (lane = 0; lane < TP_N_LANES; lane += 1) {
+        len += tp->lanes[lane].len;
     }
+
+    return len;
 }
 
-static void *_tp_thread_task(void *_tp) {
-    tp_t         *tp;
-    tp_task_t    *task;
-    tp_task_fn_t  fn;
-    void         *arg;
+/* Must be called with the mutex held. */
+static int tp_lanes_de(tp_t *tp, tp_task_t *out) {
+    int lane;
+
+    for (lane = TP_N_LANES - 1; lane >= 0; lane -= 1) {
+        if (tp_queue_de(&tp->lanes[lane], out)) { return 1; }
+    }
+
+    return 0;
+}
+
+static void *_tp_thread_task(void *_w) {
+    tp_worker_t *w;
+    tp_t        *tp;
+    tp_task_t    task;
 
-    tp = (tp_t*)_tp;
+    w  = (tp_worker_t*)_w;
+    tp = w->tp;
 
     for (;;) {
         /* Lock must be taken to wait on conditional variable. */
 
-        pthread_mutex_lock(&tp->mutex);
+        tp_lock(tp, w);
+
+        if (tp_lanes_len(tp) == 0
+        &&  tp->stop_mode == TP_DONT_STOP) {
+            tp_stat_add(&w->stats.n_parks, 1);
+        }
 
         /*
          * Wait on condition variable, check for spurious wakeups.
          * When returning from pthread_cond_wait(), we own the lock.
          */
-        while (tp->queue.len == 0
+        while (tp_lanes_len(tp) == 0
         &&     tp->stop_mode == TP_DONT_STOP) {
             pthread_cond_wait(&tp->cond, &tp->mutex);
         }
 
         if (tp->stop_mode == TP_IMMEDIATE
-        ||  (tp->stop_mode == TP_GRACEFUL && tp->queue.len == 0)) {
+        ||  (tp->stop_mode == TP_GRACEFUL && tp_lanes_len(tp) == 0)) {
             break;
         }
 
         /* Grab our task. */
-        task = tp_queue_de(&tp->queue);
-
-        if (task != NULL) {
+        if (tp_lanes_de(tp, &task)) {
             /* Get to work. */
-            fn  = task->fn;
-            arg = task->arg;
-
             tp->n_running += 1;
 
-            tp_task_free(task);
-
             pthread_mutex_unlock(&tp->mutex);
 
-            fn(arg);
+            tp_run(tp, w, &task);
 
-            pthread_mutex_lock(&tp->mutex);
+            tp_lock(tp, w);
             tp->n_running -= 1;
+            if (tp->n_running == 0 && tp_lanes_len(tp) == 0) {
+                pthread_cond_broadcast(&tp->idle_cond);
+            }
             pthread_mutex_unlock(&tp->mutex);
         }
     }
 
+    /* After TP_IMMEDIATE, the queue may never drain. Don't leave waiters hanging. */
+    pthread_cond_broadcast(&tp->idle_cond);
     pthread_mutex_unlock(&tp->mutex);
 
     pthread_exit(NULL);
@@ -173,9 +389,276 @@ static void *_tp_thread_task(void *_tp) {
     return NULL;
 }
 
-tp_t * tp_make(int n_workers) {
+static __thread tp_worker_t *tp_self;
+
+#define TP_DEQUE_INITIAL_SIZE (256)
+
+static tp_deque_array_t * tp_deque_array_make(long size) {
+    tp_deque_array_t *array;
+
+    array = (tp_deque_array_t*)malloc(sizeof(*array) + size * sizeof(tp_task_t));
+
+    array->mask    = size - 1;
+    array->retired = NULL;
+
+    return array;
+}
+
+/* Owner only. */
+static void tp_deque_push(tp_worker_t *w, tp_task_fn_t fn, void *arg, unsigned long long queued_ns) {
+    long              b;
+    long              t;
+    long              i;
+    tp_deque_array_t *array;
+    tp_deque_array_t *grown;
+    tp_task_t        *slot;
+
+    b     = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+    t     = __atomic_load_n(&w->top,    __ATOMIC_ACQUIRE);
+    array = __atomic_load_n(&w->array,  __ATOMIC_RELAXED);
+
+    if (b - t > array->mask) {
+        grown = tp_deque_array_make(2 * (array->mask + 1));
+        for (i = t; i < b; i += 1) {
+            grown->slots[i & grown->mask] = array->slots[i & array->mask];
+        }
+        grown->retired = array;
+        __atomic_store_n(&w->array, grown, __ATOMIC_RELEASE);
+        array = grown;
+    }
+
+    slot = array->slots + (b & array->mask);
+    __atomic_store_n(&slot->fn,        fn,        __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->arg,       arg,       __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->queued_ns, queued_ns, __ATOMIC_RELAXED);
+
+    /* seq_cst so that a worker about to park either sees this or is counted in n_sleeping. */
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_SEQ_CST);
+}
+
+/* Owner only. Pops the most recently pushed task. */
+static int tp_deque_take(tp_worker_t *w, tp_task_t *out) {
+    long              b;
+    long              t;
+    tp_deque_array_t *array;
+    tp_task_t        *slot;
+    int               ok;
+
+    b     = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+    array = __atomic_load_n(&w->array,  __ATOMIC_RELAXED);
+    __atomic_store_n(&w->bottom, b, __ATOMIC_SEQ_CST);
+    t     = __atomic_load_n(&w->top,    __ATOMIC_SEQ_CST);
+
+    if (t > b) {
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    slot     = array->slots + (b & array->mask);
+    out->fn        = __atomic_load_n(&slot->fn,        __ATOMIC_RELAXED);
+    out->arg       = __atomic_load_n(&slot->arg,       __ATOMIC_RELAXED);
+    out->queued_ns = __atomic_load_n(&slot->queued_ns, __ATOMIC_RELAXED);
+
+    if (t < b) { return 1; }
+
+    /* Last one: race the thieves for it. */
+    ok = __atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+
+    return ok;
+}
+
+/* Any thread. Takes the oldest task. Also fails if another thief won the race. */
+static int tp_deque_steal(tp_worker_t *w, tp_task_t *out) {
+    long              t;
+    long              b;
+    tp_deque_array_t *array;
+    tp_task_t        *slot;
+
+    t = __atomic_load_n(&w->top,    __ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&w->bottom, __ATOMIC_SEQ_CST);
+
+    if (t >= b) { return 0; }
+
+    array    = __atomic_load_n(&w->array, __ATOMIC_ACQUIRE);
+    slot     = array->slots + (t & array->mask);
+    out->fn        = __atomic_load_n(&slot->fn,        __ATOMIC_RELAXED);
+    out->arg       = __atomic_load_n(&slot->arg,       __ATOMIC_RELAXED);
+    out->queued_ns = __atomic_load_n(&slot->queued_ns, __ATOMIC_RELAXED);
+
+    return __atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static int tp_deque_empty(tp_worker_t *w) {
+    return __atomic_load_n(&w->top,    __ATOMIC_SEQ_CST)
+        >= __atomic_load_n(&w->bottom, __ATOMIC_SEQ_CST);
+}
+
+/* Must be called with the mutex held. */
+static int tp_steal_has_work(tp_t *tp) {
+    int i;
+
+    if (tp_lanes_len(tp) > 0) { return 1; }
+
+    for (i = 0; i < tp->n_workers; i += 1) {
+        if (!tp_deque_empty(tp->workers + i)) { return 1; }
+    }
+
+    return 0;
+}
+
+static int tp_steal_lane_de(tp_worker_t *self, int lane, tp_task_t *out) {
     tp_t *tp;
-    int   i;
+    int   found;
+
+    tp = self->tp;
+
+    if (__atomic_load_n(&tp->n_queued[lane], __ATOMIC_RELAXED) == 0) { return 0; }
+
+    tp_lock(tp, self);
+    if ((found = tp_queue_de(&tp->lanes[lane], out))) {
+        __atomic_sub_fetch(&tp->n_queued[lane], 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&tp->mutex);
+
+    return found;
+}
+
+/* Interactive tasks never go on the deques, so the shared lane is the only place to look for them. */
+static int tp_steal_find(tp_worker_t *self, tp_task_t *out) {
+    tp_t         *tp;
+    unsigned int  start;
+    int           i;
+    tp_worker_t  *victim;
+
+    tp = self->tp;
+
+    if (tp_steal_lane_de(self, TP_INTERACTIVE, out)) { return 1; }
+    if (tp_deque_take(self, out))                    { return 1; }
+    if (tp_steal_lane_de(self, TP_BACKGROUND, out))  { return 1; }
+
+    /* xorshift32 */
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 17;
+    self->rng ^= self->rng << 5;
+
+    start = self->rng % tp->n_workers;
+
+    for (i = 0; i < tp->n_workers; i += 1) {
+        victim = tp->workers + (start + i) % tp->n_workers;
+        if (victim == self) { continue; }
+        if (tp_deque_steal(victim, out)) {
+            tp_stat_add(&self->stats.n_steals, 1);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void tp_steal_run(tp_worker_t *w, tp_task_t *slot) {
+    tp_t *tp;
+
+    tp = w->tp;
+
+    __atomic_add_fetch(&tp->n_running, 1, __ATOMIC_RELAXED);
+
+    tp_run(tp, w, slot);
+
+    __atomic_sub_fetch(&tp->n_running, 1, __ATOMIC_RELEASE);
+
+    if (__atomic_sub_fetch(&tp->n_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&tp->mutex);
+        pthread_cond_broadcast(&tp->idle_cond);
+        pthread_mutex_unlock(&tp->mutex);
+    }
+}
+
+static void *_tp_thread_steal(void *_w) {
+    tp_worker_t *w;
+    tp_t        *tp;
+    int          stop_mode;
+    tp_task_t    slot;
+
+    w       = (tp_worker_t*)_w;
+    tp      = w->tp;
+    tp_self = w;
+
+    for (;;) {
+        stop_mode = __atomic_load_n(&tp->stop_mode, __ATOMIC_ACQUIRE);
+
+        if (stop_mode == TP_IMMEDIATE) { break; }
+
+        if (tp_steal_find(w, &slot)) {
+            tp_steal_run(w, &slot);
+            continue;
+        }
+
+        if (stop_mode == TP_GRACEFUL) { break; }
+
+        /*
+         * Park. Anyone who adds a task after we've checked sees n_sleeping
+         * and signals, and can't do that until we're waiting.
+         */
+        tp_stat_add(&w->stats.n_parks, 1);
+
+        tp_lock(tp, w);
+        __atomic_add_fetch(&tp->n_sleeping, 1, __ATOMIC_SEQ_CST);
+        while (tp->stop_mode == TP_DONT_STOP
+        &&     !tp_steal_has_work(tp)) {
+            pthread_cond_wait(&tp->cond, &tp->mutex);
+        }
+        __atomic_sub_fetch(&tp->n_sleeping, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&tp->mutex);
+    }
+
+    pthread_mutex_lock(&tp->mutex);
+    pthread_cond_broadcast(&tp->idle_cond);
+    pthread_mutex_unlock(&tp->mutex);
+
+    tp_self = NULL;
+
+    return NULL;
+}
+
+static int tp_steal_add(tp_t *tp, tp_task_fn_t fn, void *arg, int prio) {
+    int added;
+
+    if (prio == TP_BACKGROUND && tp_self != NULL && tp_self->tp == tp) {
+        if (__atomic_load_n(&tp->stop_mode, __ATOMIC_ACQUIRE) != TP_DONT_STOP) { return 0; }
+
+        __atomic_add_fetch(&tp->n_pending, 1, __ATOMIC_RELAXED);
+        tp_deque_push(tp_self, fn, arg, tp_stamp(tp));
+
+        if (__atomic_load_n(&tp->n_sleeping, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&tp->mutex);
+            pthread_cond_signal(&tp->cond);
+            pthread_mutex_unlock(&tp->mutex);
+        }
+        return 1;
+    }
+
+    pthread_mutex_lock(&tp->mutex);
+
+    added = tp->stop_mode == TP_DONT_STOP;
+    if (added) {
+        __atomic_add_fetch(&tp->n_pending, 1, __ATOMIC_RELAXED);
+        tp_queue_en(&tp->lanes[prio], fn, arg, tp_stamp(tp));
+        __atomic_add_fetch(&tp->n_queued[prio], 1, __ATOMIC_RELAXED);
+        if (tp->n_sleeping > 0) { pthread_cond_signal(&tp->cond); }
+    }
+
+    pthread_mutex_unlock(&tp->mutex);
+
+    return added;
+}
+
+tp_t * tp_make(int n_workers) { return tp_make_ex(n_workers, 0); }
+
+tp_t * tp_make_ex(int n_workers, int flags) {
+    tp_t        *tp;
+    int          i;
+    tp_worker_t *w;
 
     if (n_workers <= 0) { n_workers = 1; }
 
@@ -183,14 +666,36 @@ tp_t * tp_make(int n_workers) {
 
     pthread_mutex_init(&tp->mutex, NULL);
     pthread_cond_init(&tp->cond, NULL);
-    tp->threads   = (pthread_t*)malloc(n_workers * sizeof(pthread_t));
-    tp->queue     = tp_queue_make();
-    tp->stop_mode = TP_DONT_STOP;
-    tp->n_started = 0;
-    tp->n_running = 0;
+    pthread_cond_init(&tp->idle_cond, NULL);
+    tp->threads    = (pthread_t*)malloc(n_workers * sizeof(pthread_t));
+    for (i = 0; i < TP_N_LANES; i += 1) {
+        tp->lanes[i]    = tp_queue_make();
+        tp->n_queued[i] = 0;
+    }
+    tp->flags      = flags;
+    tp->stop_mode  = TP_DONT_STOP;
+    tp->n_started  = 0;
+    tp->n_running  = 0;
+    tp->n_workers  = n_workers;
+    tp->workers    = (tp_worker_t*)aligned_alloc(__alignof__(tp_worker_t), n_workers * sizeof(tp_worker_t));
+    tp->n_pending  = 0;
+    tp->n_sleeping = 0;
 
     for (i = 0; i < n_workers; i += 1) {
-        pthread_create(tp->threads + i, NULL, _tp_thread_task, tp);
+        w             = tp->workers + i;
+        memset(w, 0, sizeof(*w));
+        w->array      = (flags & TP_STEAL) ? tp_deque_array_make(TP_DEQUE_INITIAL_SIZE) : NULL;
+        w->tp         = tp;
+        w->rng        = 0x9E3779B9u * (i + 1);
+        w->idle_since = tp_stamp(tp);
+    }
+
+    for (i = 0; i < n_workers; i += 1) {
+        if (flags & TP_STEAL) {
+            pthread_create(tp->threads + i, NULL, _tp_thread_steal, tp->workers + i);
+        } else {
+            pthread_create(tp->threads + i, NULL, _tp_thread_task, tp->workers + i);
+        }
         tp->n_started += 1;
     }
 
@@ -198,9 +703,24 @@ tp_t * tp_make(int n_workers) {
 }
 
 void tp_free(tp_t *tp) {
-    tp_queue_clear(&tp->queue);
+    int               i;
+    tp_deque_array_t *array;
+    tp_deque_array_t *next;
+
+    for (i = 0; i < tp->n_workers; i += 1) {
+        for (array = tp->workers[i].array; array != NULL; array = next) {
+            next = array->retired;
+            free(array);
+        }
+    }
+    free(tp->workers);
+
+    for (i = 0; i < TP_N_LANES; i += 1) {
+        tp_queue_free(&tp->lanes[i]);
+    }
     free(tp->threads);
     pthread_cond_destroy(&tp->cond);
+    pthread_cond_destroy(&tp->idle_cond);
     pthread_mutex_destroy(&tp->mutex);
     free(tp);
 }
@@ -215,13 +735,15 @@ void tp_stop(tp_t *tp, int stop_mode) {
         return;
     }
 
+    pthread_mutex_lock(&tp->mutex);
+
     if (stop_mode     == TP_DONT_STOP
     ||  tp->stop_mode != TP_DONT_STOP) {
         pthread_mutex_unlock(&tp->mutex);
         return;
     }
 
-    tp->stop_mode = stop_mode;
+    __atomic_store_n(&tp->stop_mode, stop_mode, __ATOMIC_RELEASE);
 
     pthread_cond_broadcast(&tp->cond);
     pthread_mutex_unlock(&tp->mutex);
@@ -231,42 +753,362 @@ void tp_stop(tp_t *tp, int stop_mode) {
     }
 }
 
-void tp_add_task(tp_t *tp, tp_task_fn_t fn, void *arg) {
+int tp_add_task(tp_t *tp, tp_task_fn_t fn, void *arg) {
+    return tp_add_task_ex(tp, fn, arg, TP_BACKGROUND);
+}
+
+/* Returns 0 if the pool is stopping and the task was dropped. */
+int tp_add_task_ex(tp_t *tp, tp_task_fn_t fn, void *arg, int prio) {
+    int added;
+
+    if (prio < 0 || prio >= TP_N_LANES) { prio = TP_BACKGROUND; }
+
+    if (tp->flags & TP_STEAL) {
+        return tp_steal_add(tp, fn, arg, prio);
+    }
+
     pthread_mutex_lock(&tp->mutex);
 
-    if (tp->stop_mode == TP_DONT_STOP) {
-        tp_queue_en(&tp->queue, fn, arg);
+    added = tp->stop_mode == TP_DONT_STOP;
+    if (added) {
+        tp_queue_en(&tp->lanes[prio], fn, arg, tp_stamp(tp));
         pthread_cond_signal(&tp->cond);
     }
 
     pthread_mutex_unlock(&tp->mutex);
+
+    return added;
+}
+
+/* Must be called with the mutex held. */
+static int tp_is_idle(tp_t *tp) {
+    if (tp->flags & TP_STEAL) {
+        return __atomic_load_n(&tp->n_pending, __ATOMIC_ACQUIRE) == 0
+            || (tp->stop_mode != TP_DONT_STOP && __atomic_load_n(&tp->n_running, __ATOMIC_ACQUIRE) == 0);
+    }
+
+    return tp->n_running == 0
+        && (tp_lanes_len(tp) == 0 || tp->stop_mode != TP_DONT_STOP);
 }
 
 void tp_wait(tp_t *tp) {
+    pthread_mutex_lock(&tp->mutex);
+
+    while (!tp_is_idle(tp)) {
+        pthread_cond_wait(&tp->idle_cond, &tp->mutex);
+    }
+
+    pthread_mutex_unlock(&tp->mutex);
+}
+
+/* Absolute CLOCK_REALTIME time timeout_ms from now, for pthread_cond_timedwait(). */
+static void tp_deadline(struct timespec *ts, int timeout_ms) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec  += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec  += 1;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/* Like tp_wait(), but gives up after timeout_ms. Returns 1 if the pool is idle. */
+int tp_wait_timeout(tp_t *tp, int timeout_ms) {
     struct timespec ts;
+    int             r;
 
-    ts.tv_sec  = 0;
-    ts.tv_nsec = 100000; /* 100 microseconds */
+    tp_deadline(&ts, timeout_ms);
 
-    for (;;) {
-        pthread_mutex_lock(&tp->mutex);
+    pthread_mutex_lock(&tp->mutex);
 
-        if (tp->queue.len == 0
-        &&  tp->n_running == 0) {
-            pthread_mutex_unlock(&tp->mutex);
+    while (!(r = tp_is_idle(tp))) {
+        if (pthread_cond_timedwait(&tp->idle_cond, &tp->mutex, &ts) != 0) {
+            r = tp_is_idle(tp);
             break;
         }
+    }
+
+    pthread_mutex_unlock(&tp->mutex);
+
+    return r;
+}
+
+#define TP_GROUP_BLOCK_SIZE (256)
+
+tp_group_t * tp_group_make(tp_t *tp) { return tp_group_make_ex(tp, TP_BACKGROUND); }
+
+/* Every task in the group goes into the prio lane. */
+tp_group_t * tp_group_make_ex(tp_t *tp, int prio) {
+    tp_group_t *group;
+
+    group = (tp_group_t*)malloc(sizeof(*group));
+
+    group->tp        = tp;
+    group->prio      = prio;
+    pthread_mutex_init(&group->mutex, NULL);
+    pthread_cond_init(&group->done_cond, NULL);
+    group->n_pending = 0;
+    group->n_helpers = 0;
+    group->free_list = NULL;
+    group->blocks    = NULL;
+    group->n_blocks  = 0;
+
+    return group;
+}
+
+void tp_group_free(tp_group_t *group) {
+    int i;
+
+    tp_group_wait(group);
+
+    for (i = 0; i < group->n_blocks; i += 1) {
+        free(group->blocks[i]);
+    }
+    free(group->blocks);
 
+    pthread_cond_destroy(&group->done_cond);
+    pthread_mutex_destroy(&group->mutex);
+    free(group);
+}
+
+/* Workers helping in tp_group_wait() sleep on the pool's cond, not done_cond, so they're woken there too. */
+static void tp_group_task_done(tp_group_t *group, tp_group_task_t *task) {
+    tp_t *tp;
+    int   wake;
+
+    tp = group->tp;
+
+    pthread_mutex_lock(&group->mutex);
+    task->next_free  = group->free_list;
+    group->free_list = task;
+    wake = 0;
+    if (__atomic_sub_fetch(&group->n_pending, 1, __ATOMIC_RELEASE) == 0) {
+        pthread_cond_broadcast(&group->done_cond);
+        wake = group->n_helpers > 0;
+    }
+    pthread_mutex_unlock(&group->mutex);
+
+    /* The group may be gone by now, but the pool isn't. */
+    if (wake) {
+        pthread_mutex_lock(&tp->mutex);
+        pthread_cond_broadcast(&tp->cond);
         pthread_mutex_unlock(&tp->mutex);
-        nanosleep(&ts, NULL);
     }
 }
 
+static void _tp_group_run(void *_task) {
+    tp_group_task_t *task;
+    tp_group_t      *group;
+    void            *result;
+
+    task  = (tp_group_task_t*)_task;
+    group = task->group;
+
+    if (task->future_fn != NULL) {
+        result = task->future_fn(task->arg);
+        if (task->result != NULL) { *task->result = result; }
+    } else {
+        task->fn(task->arg);
+    }
+
+    tp_group_task_done(group, task);
+}
+
+static int tp_group_add(tp_group_t *group, tp_task_fn_t fn, tp_thread_fn_t future_fn, void *arg, void **result) {
+    tp_group_task_t *task;
+    tp_group_task_t *block;
+    int              i;
+
+    pthread_mutex_lock(&group->mutex);
+
+    if (group->free_list == NULL) {
+        block = (tp_group_task_t*)malloc(TP_GROUP_BLOCK_SIZE * sizeof(*block));
+        for (i = 0; i < TP_GROUP_BLOCK_SIZE; i += 1) {
+            block[i].next_free = i + 1 < TP_GROUP_BLOCK_SIZE ? block + i + 1 : NULL;
+        }
+        group->blocks = (tp_group_task_t**)realloc(group->blocks, (group->n_blocks + 1) * sizeof(*group->blocks));
+        group->blocks[group->n_blocks] = block;
+        group->n_blocks  += 1;
+        group->free_list  = block;
+    }
+
+    task             = group->free_list;
+    group->free_list = task->next_free;
+    __atomic_add_fetch(&group->n_pending, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&group->mutex);
+
+    task->group     = group;
+    task->fn        = fn;
+    task->future_fn = future_fn;
+    task->arg       = arg;
+    task->result    = result;
+
+    if (!tp_add_task_ex(group->tp, _tp_group_run, task, group->prio)) {
+        tp_group_task_done(group, task);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Returns 0 if the pool is stopping and the task was dropped. */
+int tp_group_add_task(tp_group_t *group, tp_task_fn_t fn, void *arg) {
+    return tp_group_add(group, fn, NULL, arg, NULL);
+}
+
+/* *result is set when fn returns. It's safe to read once the group has been waited on. */
+int tp_group_add_future(tp_group_t *group, tp_thread_fn_t fn, void *arg, void **result) {
+    return tp_group_add(group, NULL, fn, arg, result);
+}
+
+void tp_group_wait(tp_group_t *group) {
+    tp_t      *tp;
+    tp_task_t  task;
+
+    tp = group->tp;
+
+    /* A TP_STEAL worker waiting on its own pool runs tasks meanwhile, so the pool can't run out of workers. */
+    if (tp_self != NULL && tp_self->tp == tp) {
+        pthread_mutex_lock(&group->mutex);
+        group->n_helpers += 1;
+        pthread_mutex_unlock(&group->mutex);
+
+        while (!tp_group_idle(group)) {
+            if (tp_steal_find(tp_self, &task)) {
+                tp_steal_run(tp_self, &task);
+                continue;
+            }
+
+            /* A stopping pool takes no new tasks, so the rest of the group is running elsewhere. */
+            if (__atomic_load_n(&tp->stop_mode, __ATOMIC_ACQUIRE) != TP_DONT_STOP) { break; }
+
+            /* Park like an idle worker, until there's work or the group is done. */
+            tp_lock(tp, tp_self);
+            __atomic_add_fetch(&tp->n_sleeping, 1, __ATOMIC_SEQ_CST);
+            while (tp->stop_mode == TP_DONT_STOP
+            &&     __atomic_load_n(&group->n_pending, __ATOMIC_ACQUIRE) > 0
+            &&     !tp_steal_has_work(tp)) {
+                pthread_cond_wait(&tp->cond, &tp->mutex);
+            }
+            __atomic_sub_fetch(&tp->n_sleeping, 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&tp->mutex);
+        }
+
+        pthread_mutex_lock(&group->mutex);
+        group->n_helpers -= 1;
+        pthread_mutex_unlock(&group->mutex);
+    }
+
+    pthread_mutex_lock(&group->mutex);
+
+    while (group->n_pending > 0) {
+        pthread_cond_wait(&group->done_cond, &group->mutex);
+    }
+
+    pthread_mutex_unlock(&group->mutex);
+}
+
+/* Returns 1 if every task in the group has finished. */
+int tp_group_wait_timeout(tp_group_t *group, int timeout_ms) {
+    struct timespec ts;
+    int             r;
+
+    tp_deadline(&ts, timeout_ms);
+
+    pthread_mutex_lock(&group->mutex);
+
+    while (group->n_pending > 0) {
+        if (pthread_cond_timedwait(&group->done_cond, &group->mutex, &ts) != 0) { break; }
+    }
+    r = group->n_pending == 0;
+
+    pthread_mutex_unlock(&group->mutex);
+
+    return r;
+}
+
+int tp_group_idle(tp_group_t *group) {
+    int r;
+
+    pthread_mutex_lock(&group->mutex);
+    r = group->n_pending == 0;
+    pthread_mutex_unlock(&group->mutex);
+
+    return r;
+}
+
+int tp_n_workers(tp_t *tp) { return tp->n_workers; }
+
+/*
+ * Snapshot of a worker's counters since the pool started, including the task
+ * or idle stretch it's in the middle of. Workers don't stop to be read, so
+ * the fields aren't exactly consistent with each other. Returns 0 if there's
+ * no such worker.
+ */
+int tp_get_stats(tp_t *tp, int worker, tp_stats_t *out) {
+    tp_worker_t        *w;
+    tp_stats_t         *stats;
+    unsigned long long  now;
+    unsigned long long  since;
+    clockid_t           clock;
+    struct timespec     ts;
+
+    memset(out, 0, sizeof(*out));
+
+    if (worker < 0 || worker >= tp->n_started) { return 0; }
+
+    w     = tp->workers + worker;
+    stats = &w->stats;
+
+    out->n_tasks     = __atomic_load_n(&stats->n_tasks,     __ATOMIC_RELAXED);
+    out->n_steals    = __atomic_load_n(&stats->n_steals,    __ATOMIC_RELAXED);
+    out->n_parks     = __atomic_load_n(&stats->n_parks,     __ATOMIC_RELAXED);
+    out->busy_ns     = __atomic_load_n(&stats->busy_ns,     __ATOMIC_RELAXED);
+    out->idle_ns     = __atomic_load_n(&stats->idle_ns,     __ATOMIC_RELAXED);
+    out->lock_ns     = __atomic_load_n(&stats->lock_ns,     __ATOMIC_RELAXED);
+    out->wait_ns     = __atomic_load_n(&stats->wait_ns,     __ATOMIC_RELAXED);
+    out->max_wait_ns = __atomic_load_n(&stats->max_wait_ns, __ATOMIC_RELAXED);
+
+    if (!(tp->flags & TP_STATS)) { return 1; }
+
+    now = tp_now_ns();
+    if ((since = __atomic_load_n(&w->busy_since, __ATOMIC_RELAXED)) != 0 && now > since) {
+        out->busy_ns += now - since;
+    }
+    if ((since = __atomic_load_n(&w->idle_since, __ATOMIC_RELAXED)) != 0 && now > since) {
+        out->idle_ns += now - since;
+    }
+
+    /* Only while the pool is running: a stopped pool's threads have been joined. */
+    if (__atomic_load_n(&tp->stop_mode, __ATOMIC_ACQUIRE) == TP_DONT_STOP
+    &&  pthread_getcpuclockid(tp->threads[worker], &clock) == 0
+    &&  clock_gettime(clock, &ts) == 0) {
+        out->cpu_ns = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    return 1;
+}
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+/* Pins every worker to cpus. Returns 0 or an errno. */
+int tp_set_affinity(tp_t *tp, const cpu_set_t *cpus) {
+    int i;
+    int err;
+
+    for (i = 0; i < tp->n_started; i += 1) {
+        if ((err = pthread_setaffinity_np(tp->threads[i], sizeof(*cpus), cpus)) != 0) { return err; }
+    }
+
+    return 0;
+}
+#endif
+
 int tp_running(tp_t *tp) {
     int r;
 
     pthread_mutex_lock(&tp->mutex);
-    r = tp->n_running;
+    r = __atomic_load_n(&tp->n_running, __ATOMIC_ACQUIRE);
     pthread_mutex_unlock(&tp->mutex);
 
     return r;
@@ -276,7 +1118,11 @@ int tp_idle(tp_t *tp) {
     int r;
 
     pthread_mutex_lock(&tp->mutex);
-    r = (tp->n_running == 0) & (tp->queue.len == 0);
+    if (tp->flags & TP_STEAL) {
+        r = __atomic_load_n(&tp->n_pending, __ATOMIC_ACQUIRE) == 0;
+    } else {
+        r = (tp->n_running == 0) & (tp_lanes_len(tp) == 0);
+    }
     pthread_mutex_unlock(&tp->mutex);
 
     return r;
@@ -0,0 +1,204 @@
+#ifndef __URING_H__
+#define __URING_H__
+
+/*
+ * Just enough io_uring to batch requests without liburing: set up a ring,
+ * queue SQEs, submit them and wait for their completions in one syscall.
+ * Linux only.
+ */
+
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+typedef struct {
+    int                  fd;
+    unsigned             sq_entries;
+    unsigned            *sq_head;
+    unsigned            *sq_tail;
+    unsigned            *sq_mask;
+    unsigned            *sq_array;
+    unsigned             sq_local_tail;
+    unsigned             n_queued;
+    unsigned            *cq_head;
+    unsigned            *cq_tail;
+    unsigned            *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void                *sq_ptr;
+    size_t               sq_size;
+    void                *cq_ptr;
+    size_t               cq_size;
+    size_t               sqes_size;
+} uring_t;
+
+
+int                   uring_init(uring_t *ring, unsigned entries);
+void                  uring_free(uring_t *ring);
+int                   uring_supports(uring_t *ring, const int *ops, int n_ops);
+struct io_uring_sqe * uring_get_sqe(uring_t *ring);
+int                   uring_submit_and_wait(uring_t *ring, unsigned wait_nr);
+struct io_uring_cqe * uring_peek_cqe(uring_t *ring);
+void                  uring_cqe_seen(uring_t *ring);
+
+#endif
+
+#endif
+
+#if defined(URING_IMPLEMENTATION) && defined(__linux__)
+
+/* Returns 0 on success or a negative errno. */
+int uring_init(uring_t *ring, unsigned entries) {
+    struct io_uring_params p;
+    char                  *sq;
+    char                  *cq;
+    int                    r;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        r        = -errno;
+        errno    = 0;
+        return r;
+    }
+
+    ring->sq_size   = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size   = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) { ring->sq_size = ring->cq_size; }
+        ring->cq_size = ring->sq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) { goto out_err; }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) { ring->cq_ptr = NULL; goto out_err; }
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) { ring->sqes = NULL; goto out_err; }
+
+    sq = ring->sq_ptr;
+    cq = ring->cq_ptr;
+
+    ring->sq_entries    = p.sq_entries;
+    ring->sq_head       = (unsigned*)(sq + p.sq_off.head);
+    ring->sq_tail       = (unsigned*)(sq + p.sq_off.tail);
+    ring->sq_mask       = (unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sq_array      = (unsigned*)(sq + p.sq_off.array);
+    ring->sq_local_tail = *ring->sq_tail;
+    ring->cq_head       = (unsigned*)(cq + p.cq_off.head);
+    ring->cq_tail       = (unsigned*)(cq + p.cq_off.tail);
+    ring->cq_mask       = (unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes          = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    return 0;
+
+out_err:;
+    if (ring->sq_ptr == MAP_FAILED) { ring->sq_ptr = NULL; }
+    uring_free(ring);
+    errno = 0;
+    return -ENOMEM;
+}
+
+void uring_free(uring_t *ring) {
+    if (ring->sqes != NULL)                                 { munmap(ring->sqes, ring->sqes_size);  }
+    if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr) { munmap(ring->cq_ptr, ring->cq_size); }
+    if (ring->sq_ptr != NULL)                               { munmap(ring->sq_ptr, ring->sq_size);  }
+    if (ring->fd >= 0)                                      { close(ring->fd);                      }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+/* Returns 1 if the kernel implements every opcode in ops. */
+int uring_supports(uring_t *ring, const int *ops, int n_ops) {
+    struct io_uring_probe *probe;
+    int                    i;
+    int                    ok;
+
+    probe = calloc(1, sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op));
+
+    ok = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+
+    for (i = 0; ok && i < n_ops; i += 1) {
+        ok = ops[i] <= probe->last_op
+          && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+
+    return ok;
+}
+
+/* Returns a zeroed SQE, or NULL if the submission queue is full. */
+struct io_uring_sqe * uring_get_sqe(uring_t *ring) {
+    unsigned             head;
+    unsigned             idx;
+    struct io_uring_sqe *sqe;
+
+    head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->sq_entries) { return NULL; }
+
+    idx                 = ring->sq_local_tail & *ring->sq_mask;
+    ring->sq_array[idx] = idx;
+    sqe                 = &ring->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+
+    ring->sq_local_tail += 1;
+    ring->n_queued      += 1;
+
+    return sqe;
+}
+
+/* Submits everything queued and waits for wait_nr completions. Returns the number submitted or a negative errno. */
+int uring_submit_and_wait(uring_t *ring, unsigned wait_nr) {
+    int r;
+
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+    do {
+        r = syscall(__NR_io_uring_enter, ring->fd, ring->n_queued, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (r < 0 && errno == EINTR);
+
+    if (r < 0) {
+        r     = -errno;
+        errno = 0;
+        return r;
+    }
+
+    ring->n_queued -= r;
+
+    return r;
+}
+
+struct io_uring_cqe * uring_peek_cqe(uring_t *ring) {
+    unsigned head;
+
+    head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) { return NULL; }
+
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+void uring_cqe_seen(uring_t *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+#endif